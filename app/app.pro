@@ -0,0 +1,46 @@
+#-------------------------------------------------
+#
+# Project created by QtCreator 2016-03-26T20:37:38
+#
+#-------------------------------------------------
+
+QT       += opengl
+
+TARGET = brickExplosion
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../include $$PWD/../meshdata
+DEPENDPATH += $$PWD/../meshdata
+
+CONFIG += console c++11
+
+SOURCES += main.cpp\
+        glwidget.cpp \
+    mainwindow.cpp \
+    mesh.cpp \
+    brickbuilder.cpp \
+    explosionsim.cpp \
+    occlusion.cpp
+
+HEADERS  += glwidget.h \
+    mainwindow.h \
+    mesh.h \
+    brickbuilder.h \
+    explosionsim.h \
+    occlusion.h
+
+RESOURCES += \
+    shaders.qrc
+
+FORMS += \
+    mainwindow.ui
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../meshdata/release/ -lmeshdata
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../meshdata/debug/ -lmeshdata
+else:unix: LIBS += -L$$OUT_PWD/../meshdata/ -lmeshdata
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../meshdata/release/libmeshdata.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../meshdata/debug/libmeshdata.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../meshdata/release/meshdata.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../meshdata/debug/meshdata.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/../meshdata/libmeshdata.a
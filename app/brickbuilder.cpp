@@ -0,0 +1,80 @@
+
+#include "brickbuilder.h"
+
+BrickBuilder::BrickBuilder(){
+    hasJob=busy=hasResult=quit=false;
+    jobVersion=0;
+    cancel=0;
+    worker=std::thread(&BrickBuilder::run,this);
+}
+
+BrickBuilder::~BrickBuilder(){
+    {
+        std::lock_guard<std::mutex> l(lock);
+        quit=true;
+        cancel=1;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void BrickBuilder::request(const BrickParams &p, const QString &cacheFile, uint cacheVersion){
+    {
+        std::lock_guard<std::mutex> l(lock);
+        jobParams=p;
+        jobFile=cacheFile;
+        jobVersion=cacheVersion;
+        hasJob=true;
+        if(busy)
+            cancel=1;
+    }
+    wake.notify_one();
+}
+
+void BrickBuilder::wait(){
+    std::unique_lock<std::mutex> l(lock);
+    idle.wait(l,[this]{return !hasJob && !busy;});
+}
+
+bool BrickBuilder::takeResult(MeshData &brick){
+    std::lock_guard<std::mutex> l(lock);
+    if(!hasResult)
+        return false;
+    brick.swapVertices(result);
+    result.clearVertices();
+    hasResult=false;
+    return true;
+}
+
+void BrickBuilder::run(){
+    std::unique_lock<std::mutex> l(lock);
+    while(true){
+        wake.wait(l,[this]{return hasJob || quit;});
+        if(quit)
+            break;
+        BrickParams p=jobParams;
+        QString file=jobFile;
+        uint version=jobVersion;
+        hasJob=false;
+        busy=true;
+        cancel=0;
+        l.unlock();
+
+        MeshData m;
+        bool built=pipeline.build(m,p,file,version,&cancel);
+
+        l.lock();
+        busy=false;
+        if(built){
+            // an older brick nobody picked up yet just gets replaced
+            result.swapVertices(m);
+            hasResult=true;
+        }
+        idle.notify_all();
+        if(built && onDone){
+            l.unlock();
+            onDone();
+            l.lock();
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef BRICKBUILDER_H
+#define BRICKBUILDER_H
+
+// brickbuilder.h
+// Runs the BrickPipeline on a worker thread so the window keeps drawing the old brick
+// while a new one is made. Only the newest request matters: one still waiting gets
+// replaced and one already running is cancelled.
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "brickpipeline.h"
+
+class BrickBuilder{
+    public:
+        BrickBuilder();
+        ~BrickBuilder();
+
+        void request(const BrickParams &p, const QString &cacheFile, uint cacheVersion);
+        // blocks until everything requested so far is done
+        void wait();
+        // if a new brick is ready, swaps its vertices into brick and returns true.
+        // Called from paintGL, brick's buffers still need updating after.
+        bool takeResult(MeshData &brick);
+
+        // called on the worker thread whenever a new brick is ready
+        std::function<void()> onDone;
+
+    private:
+        void run();
+
+        BrickPipeline pipeline;     // only touched by the worker
+        MeshData result;
+
+        std::mutex lock;
+        std::condition_variable wake,idle;
+        bool hasJob,busy,hasResult,quit;
+        BrickParams jobParams;
+        QString jobFile;
+        uint jobVersion;
+        std::atomic<int> cancel;
+
+        std::thread worker;
+};
+
+#endif // BRICKBUILDER_H
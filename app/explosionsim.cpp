@@ -0,0 +1,146 @@
+#include "explosionsim.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <cstddef>
+#include <iostream>
+
+using glm::vec3;
+using glm::vec4;
+using std::vector;
+using std::cout;
+using std::endl;
+
+// one brick's state, laid out the way the shader's outputs come out of transform feedback
+struct SimBrick{
+    vec4 pos;       // w is the on-ground flag
+    vec4 rot;       // quaternion as xyzw
+    vec3 vel;
+};
+static_assert(sizeof(SimBrick)==44,"SimBrick has to match the feedback outputs");
+
+ExplosionSim::ExplosionSim(){
+    gl=0;
+    program=0;
+    gravity=.0015f;
+    cur=0;
+    nBricks=0;
+    active=0;
+}
+
+ExplosionSim::~ExplosionSim(){
+}
+
+void ExplosionSim::init(QOGLVER *context){
+    gl=context;
+}
+
+void ExplosionSim::initialize(GLuint prog){
+    program=prog;
+    const char *outs[3]={"outPos","outRot","outVel"};
+    gl->glTransformFeedbackVaryings(program,3,outs,GL_INTERLEAVED_ATTRIBS);
+    gl->glLinkProgram(program);
+    GLint linked;
+    gl->glGetProgramiv(program,GL_LINK_STATUS,&linked);
+    if(!linked)
+        cout<<"explosion sim: link failed"<<endl;
+    spinsLoc=gl->glGetUniformLocation(program,"spins");
+    gravityLoc=gl->glGetUniformLocation(program,"gravity");
+
+    gl->glGenBuffers(2,state);
+    gl->glGenBuffers(1,&scaleBuf);
+    gl->glGenVertexArrays(2,vaos);
+    const char *ins[3]={"simPos","simRot","simVel"};
+    const size_t offsets[3]={offsetof(SimBrick,pos),offsetof(SimBrick,rot),offsetof(SimBrick,vel)};
+    for(int s=0;s<2;s++){
+        gl->glBindVertexArray(vaos[s]);
+        gl->glBindBuffer(GL_ARRAY_BUFFER,state[s]);
+        for(int i=0;i<3;i++){
+            GLint loc=gl->glGetAttribLocation(program,ins[i]);
+            gl->glEnableVertexAttribArray(loc);
+            gl->glVertexAttribPointer(loc,i==2? 3 : 4,GL_FLOAT,GL_FALSE,sizeof(SimBrick),(void*)offsets[i]);
+        }
+    }
+    gl->glBindVertexArray(0);
+}
+
+void ExplosionSim::start(InstancedMesh &brick, const glm::quat *spins, uint nSpins){
+    nBricks=brick.instances.size();
+    vector<SimBrick> bricks(nBricks);
+    vector<vec3> scales(nBricks);
+    for(uint i=0;i<nBricks;i++){
+        const InstanceXform &x=brick.instances[i];
+        bricks[i].pos=vec4(x.pos,brick.instanceOnGround[i]? 1 : 0);
+        bricks[i].rot=vec4(x.rot.x,x.rot.y,x.rot.z,x.rot.w);
+        bricks[i].vel=brick.instanceVel[i];
+        scales[i]=x.scale;
+    }
+    // both get the full size up front, the feedback writes into whichever is next
+    cur=0;
+    gl->glBindBuffer(GL_ARRAY_BUFFER,state[0]);
+    gl->glBufferData(GL_ARRAY_BUFFER,nBricks*sizeof(SimBrick),bricks.data(),GL_DYNAMIC_COPY);
+    gl->glBindBuffer(GL_ARRAY_BUFFER,state[1]);
+    gl->glBufferData(GL_ARRAY_BUFFER,nBricks*sizeof(SimBrick),0,GL_DYNAMIC_COPY);
+    gl->glBindBuffer(GL_ARRAY_BUFFER,scaleBuf);
+    gl->glBufferData(GL_ARRAY_BUFFER,nBricks*sizeof(vec3),scales.data(),GL_STATIC_DRAW);
+
+    vector<vec4> spinVecs(nSpins);
+    for(uint i=0;i<nSpins;i++)
+        spinVecs[i]=vec4(spins[i].x,spins[i].y,spins[i].z,spins[i].w);
+    gl->glUseProgram(program);
+    gl->glUniform4fv(spinsLoc,nSpins,glm::value_ptr(spinVecs[0]));
+    gl->glUniform1f(gravityLoc,gravity);
+
+    active=1;
+    brick.setExternalInstances(1);
+    pointBrickAt(brick);
+}
+
+void ExplosionSim::step(InstancedMesh &brick){
+    if(!active || !nBricks)
+        return;
+    gl->glUseProgram(program);
+    gl->glEnable(GL_RASTERIZER_DISCARD);
+    gl->glBindVertexArray(vaos[cur]);
+    gl->glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER,0,state[1-cur]);
+    gl->glBeginTransformFeedback(GL_POINTS);
+    gl->glDrawArrays(GL_POINTS,0,nBricks);
+    gl->glEndTransformFeedback();
+    gl->glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER,0,0);
+    gl->glDisable(GL_RASTERIZER_DISCARD);
+    gl->glBindVertexArray(0);
+    cur=1-cur;
+    pointBrickAt(brick);
+}
+
+void ExplosionSim::stop(InstancedMesh &brick){
+    if(!active)
+        return;
+    active=0;
+    // the brick may have been cleared or rebuilt since start
+    if(brick.instances.size()==nBricks && nBricks){
+        vector<SimBrick> bricks(nBricks);
+        gl->glBindBuffer(GL_ARRAY_BUFFER,state[cur]);
+        gl->glGetBufferSubData(GL_ARRAY_BUFFER,0,nBricks*sizeof(SimBrick),bricks.data());
+        for(uint i=0;i<nBricks;i++){
+            InstanceXform &x=brick.instances[i];
+            x.pos=vec3(bricks[i].pos);
+            x.rot=glm::quat(bricks[i].rot.w,bricks[i].rot.x,bricks[i].rot.y,bricks[i].rot.z);
+            brick.instanceVel[i]=bricks[i].vel;
+            brick.instanceOnGround[i]=bricks[i].pos.w!=0;
+        }
+    }
+    nBricks=0;
+    brick.setExternalInstances(0);
+}
+
+// the instanced shader takes floats as well as the half floats it usually gets
+void ExplosionSim::pointBrickAt(InstancedMesh &brick){
+    gl->glBindVertexArray(brick.vao);
+    gl->glBindBuffer(GL_ARRAY_BUFFER,state[cur]);
+    gl->glVertexAttribPointer(brick.instancePosLoc,3,GL_FLOAT,GL_FALSE,sizeof(SimBrick),
+                              (void*)offsetof(SimBrick,pos));
+    gl->glVertexAttribPointer(brick.instanceRotLoc,4,GL_FLOAT,GL_FALSE,sizeof(SimBrick),
+                              (void*)offsetof(SimBrick,rot));
+    gl->glBindBuffer(GL_ARRAY_BUFFER,scaleBuf);
+    gl->glVertexAttribPointer(brick.instanceScaleLoc,3,GL_FLOAT,GL_FALSE,0,0);
+    gl->glBindVertexArray(0);
+}
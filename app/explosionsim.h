@@ -0,0 +1,53 @@
+#ifndef EXPLOSIONSIM_H
+#define EXPLOSIONSIM_H
+
+// explosionsim.h
+// The exploding bricks, moved on the gpu. Position, spin, velocity and the on-ground flag
+// of every brick live in two buffers; each step runs sim_explosion.glsl over one of them,
+// one point per brick, and transform feedback writes the result into the other. The
+// brick's instance attributes then point straight at that result, so nothing goes
+// through the cpu or gets uploaded while the house comes down.
+// GLWidget::brickExplosion still has the cpu version, as the reference.
+
+#include "mesh.h"
+
+class ExplosionSim{
+    public:
+        ExplosionSim();
+        ~ExplosionSim();
+
+        void init(QOGLVER *context);
+        // program is sim_explosion.glsl alone, no fragment shader. It's linked again here
+        // with its feedback outputs.
+        void initialize(GLuint program);
+
+        // copies brick's instances, velocities and ground flags to the gpu, and has brick
+        // draw from there. Brick i turns by spins[i%nSpins] each step, nSpins has to be
+        // the NSPINS the shader was loaded with.
+        void start(InstancedMesh &brick, const glm::quat *spins, uint nSpins);
+        // one frame
+        void step(InstancedMesh &brick);
+        // reads everything back into brick's arrays and gives brick its own instances back
+        void stop(InstancedMesh &brick);
+        int running(){return active;}
+
+        float gravity;
+
+    private:
+        ExplosionSim(const ExplosionSim&);
+        ExplosionSim& operator=(const ExplosionSim&);
+
+        QOGLVER *gl;
+        GLuint program;
+        GLint spinsLoc, gravityLoc;
+        GLuint state[2];        // SimBrick per brick, read from one, written to the other
+        GLuint vaos[2];         // the sim's inputs from state[i]
+        GLuint scaleBuf;        // doesn't change, so it isn't fed through the sim
+        uint cur;               // state holding the latest step
+        uint nBricks;
+        int active;
+
+        void pointBrickAt(InstancedMesh &brick);
+};
+
+#endif // EXPLOSIONSIM_H
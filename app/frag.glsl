@@ -16,6 +16,7 @@ uniform float Ka;
 uniform float attenuation;
 uniform float attenuationS;
 uniform float glow;
+uniform int flatShade;
 
 uniform int spot;
 uniform vec3 spotDir;
@@ -24,7 +25,9 @@ uniform float gatten;
 void main() {
 
     //difuse
-        vec3 norm=normalize(fnorm);
+        // flat shading takes the face normal from how fpos changes across the pixel, the
+        // mesh itself stays indexed with smooth normals
+        vec3 norm= flatShade==1? normalize(cross(dFdx(fpos),dFdy(fpos))) : normalize(fnorm);
 
         vec3 dir=lightP-fpos;
         float dist=length(dir);
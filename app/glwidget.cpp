@@ -40,8 +40,14 @@
 
 #include <QTextStream>
 #include <QColorDialog>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QDir>
+#include "meshkernels.h"
+#include "meshbuilder.h"
 
 #include <iostream>
+#include <cfloat>
 
 
 using glm::inverse;
@@ -87,6 +93,13 @@ GLWidget::GLWidget(QWidget *parent) : QOpenGLWidget(parent) {
 
     brickSpace=0.1f;
     brickRough=.5f;
+    brickSeed=1;
+    brickLod=1;
+    brickAdaptive=1;
+    brickLodNear=6.0f;
+    brickLodPixels=2.0f;
+    width=height=0;
+    brickSimplify=1;
     inset=0.05f;
     bricksPerRow=9;
     rows=9;
@@ -137,6 +150,9 @@ GLWidget::GLWidget(QWidget *parent) : QOpenGLWidget(parent) {
     timer->setTimerType(Qt::PreciseTimer);
     connect(timer,SIGNAL(timeout()),this,SLOT(animate()));
     timer->start(16);
+    // a brick finished on the worker thread gets swapped in on the next paint, which might
+    // not come on its own while the timer is paused
+    brickBuilder.onDone=[this]{ QMetaObject::invokeMethod(this,"update",Qt::QueuedConnection); };
     flyMode=false;
 
     ringLoc=vec3(0,2.4f,0);
@@ -230,7 +246,9 @@ void GLWidget::onCheckMortar(int b){
 }
 void GLWidget::onCheckBrickFlat(int b){
     brickFlatShade=b;
-    rebuildGeometry();
+    // only the shader changes, the brick keeps its shared vertices
+    brick.material.flatShade=b;
+    update();
 }
 void GLWidget::onChangeSubdivides(int val){
     subdivides=val;
@@ -242,24 +260,21 @@ void GLWidget::onChangeBrickRadius(double val){
 }
 
 void GLWidget::onChangeBrickWidth(double val){
-    unScaleBrick();
     brickWidth=val;
     scaleBrick();
-    brick.updateBuffers();
+    updateBrickLods();
     buildHouse();
 }
 void GLWidget::onChangeBrickDepth(double val){
-    unScaleBrick();
     brickDepth=val;
     scaleBrick();
-    brick.updateBuffers();
+    updateBrickLods();
     buildHouse();
 }
 void GLWidget::onChangeBrickHeight(double val){
-    unScaleBrick();
     brickHeight=val;
     scaleBrick();
-    brick.updateBuffers();
+    updateBrickLods();
     buildHouse();
 }
 void GLWidget::onChangeBrickSpace(double val){
@@ -321,9 +336,10 @@ void GLWidget::rebuildGeometry(){
 // most (all?) objects are members of my Mesh class, which has built-in generation functions.
 
 void GLWidget::generateRing(Mesh &r, float inRad, float outRad){
+    geometryScratch.reset();
     r.clearVertices();
     r.generateRing(ringColor,60,inRad,outRad);
-    r.computeNormals(1);
+    r.computeNormals(1,&geometryScratch);
     r.scale(vec3(1,.1f,1));
 
     r.transform(glm::rotate(mat4(),(float)M_PI/2,vec3(1,0,0)));
@@ -414,8 +430,14 @@ void GLWidget::generateLight(){
 void GLWidget::buildHouse(){
 
     generateFloor();
+    explosionSim.stop(brick);
     brick.clearInstances();
     mortar.clearInstances();
+    wallSections=0;
+    sectionsChanged=1;
+    // one upload of each at the end instead of one per brick
+    brick.beginInstances();
+    mortar.beginInstances();
     vec2 fin=buildWall(6,-2,6,8,1,0,0,rows-2,1);
     fin = buildWall(fin.x,fin.y,-8,fin.y,0,0,0,rows-2,1);
     fin = buildWall(fin.x,fin.y,fin.x,-8,0,0,0,rows-2,1);
@@ -434,6 +456,8 @@ void GLWidget::buildHouse(){
     fin = buildWall(fin.x,fin.y,-14,fin.y,0,0,0,rows-5,0);
     fin = buildWall(fin.x,fin.y,fin.x,-15,0,0,0,rows-5,0);
     fin = buildWall(fin.x,fin.y,22,fin.y,0,0,0,rows-5,0);
+    brick.commitInstances();
+    mortar.commitInstances();
 }
 
 // buildWall takes various parameters to build a section of brick wall by adding instances
@@ -458,11 +482,19 @@ vec2 GLWidget::buildWall(float xs, float zs, float xf, float zf,
 
     //brick.clearInstances();
 
+    // everything this call adds is one section for the occlusion culling
+    brick.setInstanceGroup(wallSections);
+    mortar.setInstanceGroup(wallSections);
+    wallSections++;
+
     float wallAngle=-glm::atan((zf-zs),(xf-xs));
 
 
     float bricklen=brickWidth+brickSpace;
     bricksPerRow=(len/bricklen);
+    // the half bricks at the ends make it a little more than a brick per row each
+    brick.beginInstances(std::max(0,(rows-startHeight)*(bricksPerRow+1)));
+    mortar.beginInstances(1);
 
     vec4 f(bricksPerRow*bricklen,0,0,0);
     f=glm::rotateY(f,wallAngle);
@@ -531,6 +563,8 @@ vec2 GLWidget::buildWall(float xs, float zs, float xf, float zf,
             brickSpace*=3.0f;
             break;
     }
+    brick.commitInstances();
+    mortar.commitInstances();
 
     return finish;
 }
@@ -548,6 +582,7 @@ void GLWidget::generateCircularMortar(float radius){
 
     mortar.clearVertices();
     mortar.generateRing(mortarColor,60,inRadius,outRadius);
+    mortar.material.flatShade=0;
     mortar.scale(vec3(1,height,1));
     mortar.translate(vec3(0,height/2,0));
 
@@ -582,73 +617,285 @@ void GLWidget::generateSimpleMortar(float angle,float x,float z, int startRow, i
 }
 
 void GLWidget::buildMortar(){
+    geometryScratch.reset();
     mortar.clearVertices();
     mortar.generateCube(mortarColor,1);
-    mortar.makeFlatShade();
-    mortar.computeNormals(1);
+    mortar.computeNormals(1,&geometryScratch);
+    // a box, the shader gives it its hard edges
+    mortar.material.flatShade=1;
     mortar.updateBuffers();
 }
 
+// Generated bricks are cached on disk, keyed by everything that goes into building one.
+// Bump the version whenever the brick generation code changes.
+#define BRICK_CACHE_VERSION 4
+
+QString GLWidget::brickCachePath(const BrickParams &p){
+    QString dir=QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(dir);
+    QString name=QString(p.adaptive? "adaptive-" : "")+QString(p.simplify? "qem-" : "")+QString("brick-v%1-s%2-seed%3-%4-%5-%6%7%8.mesh")
+            .arg(BRICK_CACHE_VERSION).arg(p.subdivides).arg(p.seed)
+            .arg(floatBits(p.radius),0,16).arg(floatBits(p.rough),0,16)
+            .arg(floatBits(p.color.r),0,16).arg(floatBits(p.color.g),0,16).arg(floatBits(p.color.b),0,16);
+    return QDir(dir).filePath(name);
+}
+
+// The brick gets built on brickBuilder's worker thread, only the steps downstream of
+// whatever setting changed get re-run (see brickpipeline.h). The old brick keeps drawing
+// until paintGL picks up the new one in swapInBrick().
 void GLWidget::rebuildBrick(vec3 col){
-    brick.clearVertices();
-    brick.generateCube(col,2);
-    brick.subdivide(subdivides);
-    brick.roundEdges(brickRadius);
-    //compute normals for to classify points as which side they are on
-    brick.computeNormals(1);
-    brick.roughen(brickRough,subdivides);
-
-    // compute normals AGAIN
-    // makeFlatShade also computes normals as it goes through the vertices
-    if(brickFlatShade)
-        brick.makeFlatShade();
-    else
-        brick.computeNormals(1);
-
-    // rescale to 1 unit
-    // should have made the cube function create a 1x1 instead but changing it
-    // messes up the roughness calculations
-    brick.scale(0.5f);
+    BrickParams p;
+    p.color=col;
+    p.subdivides=subdivides;
+    p.radius=brickRadius;
+    p.rough=brickRough;
+    p.seed=brickSeed;
+    p.adaptive=brickAdaptive;
+    p.simplify=brickSimplify;
+    brickBuilder.request(p,brickCachePath(p),BRICK_CACHE_VERSION);
+}
+
+// needs the GL context current
+bool GLWidget::swapInBrick(){
+    if(!brickBuilder.takeResult(brick))
+        return false;
+    updateBrickLods(1);
 
     //make the brick the right size according to the user inputs
     scaleBrick();
     brick.updateBuffers();
+    sectionsChanged=1;
 
+    brick.material.flatShade=brickFlatShade;
     brick.material.specular=.3f;
     brick.material.shinyness=25;
+    return true;
+}
+
+// far clipping plane of projMatrix
+#define FAR_PLANE 100.0f
+
+// Simplified lods know how far they are from the full brick, so lod l+1 takes over once
+// that error, projected to the screen, is under brickLodPixels. Generated lods don't, then
+// instances within brickLodNear of the eye get the full level and each coarser lod covers
+// twice the distance of the one before. The doubling distances also cap the simplified
+// ones, a brick's error is under a pixel or two only well past the far plane and the
+// lods would never get drawn. L turns lods off.
+void GLWidget::updateBrickLods(int report){
+    brick.lodDist.clear();
+    // the distances need the projection, resizeGL comes back here once it's set
+    if(!brickLod || !height)
+        return;
+    // pixels one unit covers at distance 1, and the brick's size
+    float pixelsPerUnit=height*projMatrix[1][1]/2;
+    float size=std::max(brickWidth,std::max(brickHeight,brickDepth));
+    for(int l=0;l<brick.getNumLods()-1;l++){
+        float err=brick.getLod(l+1).error;
+        float d=brickLodNear*(1<<l);
+        if(err>0)
+            d=std::min(d,err*size*pixelsPerUnit/brickLodPixels);
+        if(!brick.lodDist.empty())
+            d=std::max(d,brick.lodDist.back());
+        brick.lodDist.push_back(d);
+    }
+    if(report){
+        cout<<"brick lods, far plane at "<<FAR_PLANE<<endl;
+        for(int l=0;l<brick.getNumLods();l++){
+            const MeshRange &r=brick.getLod(l);
+            cout<<"brick lod "<<l<<": "<<r.nIdx/3<<" tris, error "<<r.error*size;
+            if(l>0)
+                cout<<", from "<<brick.lodDist[l-1]<<" away ("<<brickLodPixels<<" px)";
+            cout<<endl;
+        }
+    }
 }
 
 
+// times generating the brick cube and subdividing it for each detail level, against
+// generating the same brick directly with generateBrick(), printed to the console (press B).
+void GLWidget::benchmarkSubdivide(){
+    Mesh m;
+    for(int lvl=1;lvl<=6;lvl++){
+        QElapsedTimer t;
+        t.start();
+        m.clearVertices();
+        m.generateCube(brickColor,2);
+        m.subdivide(lvl);
+        double subMs=t.nsecsElapsed()/1e6;
+
+        t.restart();
+        m.generateBrick(brickColor,lvl);
+        double gridMs=t.nsecsElapsed()/1e6;
+
+        // the bulk transforms a slider change runs through
+        t.restart();
+        m.scale(vec3(brickWidth,brickHeight,brickDepth));
+        m.translate(vec3(0,1,0));
+        m.transform(glm::rotate(mat4(1),0.1f,vec3(0,1,0)));
+        double xformMs=t.nsecsElapsed()/1e6;
+
+        // vertex cache reuse of the grid as generated and after reordering
+        MeshData opt=m;
+        std::vector<OptimizeStats> stats;
+        opt.optimize(0,&stats);
+
+        cout<<"brick level "<<lvl<<": "<<m.getNumVerts()<<" verts, subdivide "
+            <<subMs<<" ms, generateBrick "<<gridMs<<" ms, scale+translate+transform ("
+            <<vec3KernelName()<<") "<<xformMs<<" ms"<<endl;
+        for(uint i=0;i<stats.size();i++)
+            cout<<"    "<<stats[i].nTris<<" tris: ACMR "<<stats[i].acmrBefore<<" -> "<<stats[i].acmrAfter<<" ("
+                <<(int)(stats[i].acmrBefore*stats[i].nTris)<<" -> "<<(int)(stats[i].acmrAfter*stats[i].nTris)
+                <<" vertex shader runs per instance)"<<endl;
+    }
+    benchmarkBrickGPU();
+}
+
+// upload and draw time of the level 5 brick, all instances, from GL timer queries, and the
+// vertex shader on its own against the old per vertex normal matrix
+void GLWidget::benchmarkBrickGPU(){
+    makeCurrent();
+    int oldSubdivides=subdivides;
+    subdivides=5;
+    rebuildBrick(brickColor);
+    brickBuilder.wait();
+    swapInBrick();
+
+    GLuint q[2];
+    glGenQueries(2,q);
+    QElapsedTimer t;
+    t.start();
+    glBeginQuery(GL_TIME_ELAPSED,q[0]);
+    brick.updateBuffers();
+    glEndQuery(GL_TIME_ELAPSED);
+    double cpuMs=t.nsecsElapsed()/1e6;
+    glBeginQuery(GL_TIME_ELAPSED,q[1]);
+    brick.render();
+    glEndQuery(GL_TIME_ELAPSED);
+
+    GLuint64 uploadNs,drawNs;
+    glGetQueryObjectui64v(q[0],GL_QUERY_RESULT,&uploadNs);
+    glGetQueryObjectui64v(q[1],GL_QUERY_RESULT,&drawNs);
+    glDeleteQueries(2,q);
+    cout<<"level 5 brick, "<<brick.getNumLods()<<" lods, "<<brick.getNumVerts()<<" verts x "<<brick.getNumInstances()
+        <<" instances: upload "<<cpuMs<<" ms cpu / "<<uploadNs/1e6<<" ms gpu, draw "
+        <<drawNs/1e6<<" ms gpu"<<endl;
+    if(brick.getPackedSaved())
+        cout<<"  packed vertices saved "<<brick.getPackedSaved()<<" bytes"<<endl;
+
+    // vertex shader alone, with nothing rasterized: the normal matrix once per draw as
+    // vert_instanced.glsl does it, against the inverse of the whole matrix every vertex.
+    // The old shader has to get the same attribute locations to use the brick's vao.
+    GLuint perVertex=loadShaders(":/vert_instanced.glsl",":/frag.glsl","#define NORMAL_MATRIX_PER_VERTEX\n");
+    const char *attribs[6]={"position","color","normal","instancePos","instanceRot","instanceScale"};
+    for(int i=0;i<6;i++)
+        glBindAttribLocation(perVertex,glGetAttribLocation(programI,attribs[i]),attribs[i]);
+    glLinkProgram(perVertex);
+    GLuint progs[2]={programI,perVertex};
+    GLuint64 vertNs[2];
+    glGenQueries(2,q);
+    glEnable(GL_RASTERIZER_DISCARD);
+    for(int i=0;i<2;i++){
+        glUseProgram(progs[i]);
+        mat3 normalMat=glm::transpose(inverse(mat3(brick.modelMatrix)));
+        glUniformMatrix4fv(glGetUniformLocation(progs[i],"projection"),1,false,value_ptr(projMatrix));
+        glUniformMatrix4fv(glGetUniformLocation(progs[i],"view"),1,false,value_ptr(viewMatrix));
+        glUniformMatrix4fv(glGetUniformLocation(progs[i],"model"),1,false,value_ptr(brick.modelMatrix));
+        glUniformMatrix3fv(glGetUniformLocation(progs[i],"modelNormal"),1,false,value_ptr(normalMat));
+        glBeginQuery(GL_TIME_ELAPSED,q[i]);
+        brick.drawInstances();
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+    glDisable(GL_RASTERIZER_DISCARD);
+    for(int i=0;i<2;i++)
+        glGetQueryObjectui64v(q[i],GL_QUERY_RESULT,&vertNs[i]);
+    glDeleteQueries(2,q);
+    glDeleteProgram(perVertex);
+    cout<<"  vertex shading only: normal matrix per draw "<<vertNs[0]/1e6<<" ms gpu, inverse per vertex "
+        <<vertNs[1]/1e6<<" ms gpu"<<endl;
+
+    subdivides=oldSubdivides;
+    rebuildBrick(brickColor);
+    brickBuilder.wait();
+    swapInBrick();
+    doneCurrent();
+}
+
+// time to build the house for 10k to 1M bricks, made by stacking more rows on the same walls,
+// printed to the console (press H). The old way, an upload in every addInstance, is timed
+// only at 10k, it's quadratic and takes minutes further up.
+void GLWidget::benchmarkBuildHouse(){
+    makeCurrent();
+    int oldRows=rows;
+    // with lods or culling on, the instance upload waits for render(). Both off, so the
+    // timings include it, and back on at the end.
+    std::vector<float> oldLodDist;
+    oldLodDist.swap(brick.lodDist);
+    brick.setCulling(0);
+    mortar.setCulling(0);
+    // bricks per row, from two heights since some walls are a few rows short
+    rows=10;
+    buildHouse();
+    int at10=brick.getNumInstances();
+    rows=20;
+    buildHouse();
+    float perRow=(brick.getNumInstances()-at10)/10.0f;
+
+    uint targets[]={10000,100000,1000000};
+    for(int i=0;i<3;i++){
+        rows=10+(int)std::ceil((targets[i]-at10)/perRow);
+        QElapsedTimer t;
+        t.start();
+        buildHouse();
+        glFinish();
+        double batchMs=t.nsecsElapsed()/1e6;
+        uint n=brick.getNumInstances();
+        cout<<"house of "<<n<<" bricks, "<<rows<<" rows: built in "<<batchMs<<" ms ("
+            <<batchMs*1e6/n<<" ns per brick)";
+
+        if(targets[i]<=10000){
+            vector<InstanceXform> xs=brick.instances;
+            brick.clearInstances();
+            t.restart();
+            for(uint k=0;k<xs.size();k++)
+                brick.addInstance(xs[k]);
+            glFinish();
+            cout<<", upload per brick "<<t.nsecsElapsed()/1e6<<" ms";
+        }
+        cout<<endl;
+    }
+
+    rows=oldRows;
+    brick.lodDist.swap(oldLodDist);
+    brick.setCulling(cullInstances);
+    mortar.setCulling(cullInstances);
+    buildHouse();
+    doneCurrent();
+    update();
+}
+
 // at some point i rendered little lines showing the normals at vertices, for
 // troubleshooting/figureing-out.
-void GLWidget::rebuildNormalMarks(Mesh mesh){
+void GLWidget::rebuildNormalMarks(const MeshData &mesh){
     normalMarks.clearVertices();
-    vector<vec3> pts,colors;
     vec3 c(1,1,1);
-    for(uint i=0;i<mesh.getNumVerts();i++){
-        pts.push_back(mesh.ptAt(i));
-        pts.push_back(mesh.ptAt(i)+mesh.normAt(i)*.2f);
-    }
+    MeshBuilder b(normalMarks);
+    b.reserve(mesh.getNumVerts()*2,0);
     //mat4 t=brick.getInstanceMat(0);
-    for(uint i=0;i<pts.size();i++){
-        //pts[i]=vec3(t*vec4(pts[i],1));
-        colors.push_back(c);
+    for(uint i=0;i<mesh.getNumVerts();i++){
+        b.addVert(mesh.ptAt(i),c);
+        b.addVert(mesh.ptAt(i)+mesh.normAt(i)*.2f,c);
     }
+    b.finish();
 
-    normalMarks.copyVertices(pts,colors);
     normalMarks.updateBuffers();
 
 
 }
 
-void GLWidget::unScaleBrick(){
-    vec3 s(brickWidth,brickHeight,brickDepth);
-    brick.scale(1.0f/s);
-}
-
+// the brick mesh stays unit sized, its dimensions go in the model matrix so resizing
+// doesn't touch the vertices
 void GLWidget::scaleBrick(){
-    vec3 s(brickWidth,brickHeight,brickDepth);
-    brick.scale(s);
+    brick.modelMatrix=scale(mat4(1.0f),vec3(brickWidth,brickHeight,brickDepth));
 }
 
 void GLWidget::updateLight(){
@@ -740,6 +987,16 @@ void GLWidget::initMeshes() {
     ring3.init((QOGLVER*)this);
     ring4.init((QOGLVER*)this);
     ring5.init((QOGLVER*)this);
+    explosionSim.init((QOGLVER*)this);
+    occlusion.init((QOGLVER*)this);
+
+    // the high-poly meshes go up as 16 byte packed vertices
+    brick.setPackedVertices(1);
+    ring1.setPackedVertices(1);
+    ring2.setPackedVertices(1);
+    ring3.setPackedVertices(1);
+    ring4.setPackedVertices(1);
+    ring5.setPackedVertices(1);
 
     ground.init((QOGLVER*)this);
     floor.init((QOGLVER*)this);
@@ -810,10 +1067,26 @@ void GLWidget::initMeshes() {
     gattenLocT=glGetUniformLocation(programT,"gatten");
 
 
+    // plain colored lines, and the occlusion query boxes
+    programS=loadShaders(":/grid_vert.glsl", ":/grid_frag.glsl");
+    glUseProgram(programS);
+    projMatrixLocS = glGetUniformLocation(programS, "projection");
+    viewMatrixLocS = glGetUniformLocation(programS, "view");
+    modelMatrixLocS = glGetUniformLocation(programS, "model");
+
+    // vertex shader only, its outputs go to transform feedback
+    std::string simDefines="#define NSPINS "+std::to_string(NSPINAXES*NSPINSPDS)+"\n";
+    programSim=loadShaders(":/sim_explosion.glsl",0,simDefines.c_str());
+    explosionSim.initialize(programSim);
+
     brick.initialize(programI,alphaLocI,kaLocI,ksLocI,kdLocI,
                      sColLocI,attLocI,attSLocI,glowLocI);
+    // the bricks move every frame once they explode, and get re-sorted by lod every frame
+    brick.setStreaming(1);
     mortar.initialize(programI,alphaLocI,kaLocI,ksLocI,kdLocI,
                       sColLocI,attLocI,attSLocI,glowLocI);
+    brick.setCulling(cullInstances);
+    mortar.setCulling(cullInstances);
 
     ring1.initialize(programU,alphaLocU,kaLocU,ksLocU,kdLocU,
                      sColLocU,attLocU,attSLocU,glowLocU);
@@ -829,6 +1102,7 @@ void GLWidget::initMeshes() {
     light.initialize(programU,alphaLocU,kaLocU,ksLocU,kdLocU,
                      sColLocU,attLocU,attSLocU,glowLocU);
     grid.initialize(programS);
+    occlusion.initialize(programS);
     normalMarks.initialize(programS);
     axes.initialize(programS);
 
@@ -931,14 +1205,18 @@ void GLWidget::initializeGL() {
 
     initMeshes();
 
+    // the first brick is waited for, there's no old one to show meanwhile
     rebuildGeometry();
+    brickBuilder.wait();
+    swapInBrick();
 }
 
 void GLWidget::resizeGL(int w, int h) {
     width = w;
     height = h;
     float aspect = (float)w/h;
-    projMatrix = perspective(45.0f, aspect, 0.01f, 100.0f);
+    projMatrix = perspective(45.0f, aspect, 0.01f, FAR_PLANE);
+    updateBrickLods(1);
 
 
     glUseProgram(programI);
@@ -984,18 +1262,34 @@ void GLWidget::paintGL() {
 
     renderSky();
 
+    swapInBrick();
+    brick.viewPos=eyePos;
+    brick.viewProj=projMatrix*viewMatrix;
+    mortar.viewProj=brick.viewProj;
+    // the walls come apart in the explosion, their boxes mean nothing until the rebuild
+    int occluding=occlusionCull && (!brickExplode || finishedRebuild);
+    if(occluding){
+        applyOcclusion();
+    }else{
+        brick.showAllGroups();
+        mortar.showAllGroups();
+    }
+    uint nSections=sectionLo.size();
+
     brick.render();
-    ring1.render();
-    ring2.render();
-    ring3.render();
-    ring4.render();
-    ring5.render();
+    if(!occluding || occlusion.visible(nSections)){
+        ring1.render();
+        ring2.render();
+        ring3.render();
+        ring4.render();
+        ring5.render();
+    }
     ground.render();
 
-    if(renderFloor && !mac)
+    if(renderFloor && !mac && (!occluding || occlusion.visible(nSections+1)))
         floor.render();
 
-    if(renderRoof && !mac)
+    if(renderRoof && !mac && (!occluding || occlusion.visible(nSections+2)))
         roof.render();
 
     if(renderMortar){
@@ -1019,6 +1313,69 @@ void GLWidget::paintGL() {
 
 
     //axes.render();
+
+    // against everything drawn above, answered in time for a later frame
+    if(occluding)
+        queryOcclusion();
+
+    if(++paintFrames%300==0){
+        // the per frame lod and cull uploads stream too, not only the cpu explosion
+        brick.reportStreaming();
+        if(cullInstances){
+            brick.reportCulling("bricks");
+            mortar.reportCulling("mortar");
+        }
+        if(occluding)
+            cout<<"occlusion: "<<occlusion.numHidden()<<" of "<<nSections+3
+                <<" boxes hidden ("<<nSections<<" wall sections, rings, floor, roof)"<<endl;
+    }
+}
+
+// last answers in: the bricks and mortar of hidden wall sections drop out of the culled
+// uploads, so this only takes them out of the draw while culling is on (C)
+void GLWidget::applyOcclusion(){
+    for(uint g=0;g<sectionLo.size();g++){
+        int hidden=!occlusion.visible(g);
+        brick.setGroupHidden(g,hidden);
+        mortar.setGroupHidden(g,hidden);
+    }
+}
+
+// a box per wall section around its bricks and mortar, then one around all five rings,
+// the floor and the roof. The section boxes only go up again when the house changed, the
+// other three every frame.
+void GLWidget::queryOcclusion(){
+    vec3 lo[3],hi[3];
+    Mesh *rings[5]={&ring1,&ring2,&ring3,&ring4,&ring5};
+    lo[0]=vec3(FLT_MAX);
+    hi[0]=vec3(-FLT_MAX);
+    for(int i=0;i<5;i++){
+        vec3 l,h;
+        rings[i]->worldBox(l,h);
+        lo[0]=glm::min(lo[0],l);
+        hi[0]=glm::max(hi[0],h);
+    }
+    floor.worldBox(lo[1],hi[1]);
+    roof.worldBox(lo[2],hi[2]);
+
+    if(sectionsChanged){
+        vector<vec3> mortarLo,mortarHi;
+        brick.groupBounds(sectionLo,sectionHi);
+        mortar.groupBounds(mortarLo,mortarHi);
+        sectionLo.resize(std::max(sectionLo.size(),mortarLo.size()),vec3(FLT_MAX));
+        sectionHi.resize(sectionLo.size(),vec3(-FLT_MAX));
+        for(uint g=0;g<mortarLo.size();g++){
+            sectionLo[g]=glm::min(sectionLo[g],mortarLo[g]);
+            sectionHi[g]=glm::max(sectionHi[g],mortarHi[g]);
+        }
+        sectionsChanged=0;
+        vector<vec3> allLo=sectionLo,allHi=sectionHi;
+        allLo.insert(allLo.end(),lo,lo+3);
+        allHi.insert(allHi.end(),hi,hi+3);
+        occlusion.setBoxes(allLo,allHi);
+    }else
+        occlusion.updateBoxes(sectionLo.size(),3,lo,hi);
+    occlusion.issue(eyePos);
 }
 
 
@@ -1029,19 +1386,30 @@ void GLWidget::brickExplosion(){
     //renderRoof=0;
     spotOn=0;
 
-    for(uint i=0;i<brick.instanceMats.size();i++){
-        if(brick.instanceOnGround[i])
-            continue;
-        brick.instanceMats[i]=translate(mat4(),brick.instanceVel[i])*brick.instanceMats[i];
-        brick.instanceMats[i]=rotate(brick.instanceMats[i],
-                                     spinSpeeds[i%NSPINSPDS],spinAxes[i%NSPINAXES]);
-
-        brick.instanceVel[i].y-=0.0015f;
-        vec3 pos(brick.instanceMats[i][3]);
-
-
-        if(pos.y<0)
-            brick.instanceOnGround[i]=1;
+    if(gpuExplosion){
+        if(!explosionSim.running()){
+            // 7 and 13 have no common factor, so turn i%NSPINS is spinSpeeds[i%NSPINSPDS]
+            // about spinAxes[i%NSPINAXES], same as below
+            glm::quat spins[NSPINAXES*NSPINSPDS];
+            for(int k=0;k<NSPINAXES*NSPINSPDS;k++)
+                spins[k]=glm::angleAxis(spinSpeeds[k%NSPINSPDS],spinAxes[k%NSPINAXES]);
+            explosionSim.start(brick,spins,NSPINAXES*NSPINSPDS);
+        }
+        explosionSim.step(brick);
+    }else{
+        for(uint i=0;i<brick.instances.size();i++){
+            if(brick.instanceOnGround[i])
+                continue;
+            // move, then spin about the brick's own axes
+            InstanceXform &x=brick.instances[i];
+            x.pos+=brick.instanceVel[i];
+            x.rot=x.rot*glm::angleAxis(spinSpeeds[i%NSPINSPDS],spinAxes[i%NSPINAXES]);
+
+            brick.instanceVel[i].y-=0.0015f;
+
+            if(x.pos.y<0)
+                brick.instanceOnGround[i]=1;
+        }
     }
 
     if(!roofOnGround){
@@ -1387,6 +1755,64 @@ void GLWidget::keyPressEvent(QKeyEvent *event){
             gatten=1;
             updateLight();
             break;
+        case Qt::Key_B:
+            benchmarkSubdivide();
+            break;
+        case Qt::Key_H:
+            benchmarkBuildHouse();
+            break;
+        case Qt::Key_X:
+            // explosion on the gpu or the cpu, a running one carries on where it is
+            gpuExplosion=!gpuExplosion;
+            if(!gpuExplosion){
+                makeCurrent();
+                explosionSim.stop(brick);
+                doneCurrent();
+            }
+            cout<<"explosion on the "<<(gpuExplosion? "gpu" : "cpu")<<endl;
+            break;
+        case Qt::Key_C:
+            // frustum culling of the brick and mortar instances on/off
+            cullInstances=!cullInstances;
+            makeCurrent();
+            // culling re-sorts the bricks, a gpu explosion has to hand them back first. It
+            // starts again next frame from the new order.
+            explosionSim.stop(brick);
+            brick.setCulling(cullInstances);
+            mortar.setCulling(cullInstances);
+            doneCurrent();
+            cout<<"instance culling "<<(cullInstances? "on" : "off")<<endl;
+            update();
+            break;
+        case Qt::Key_O:
+            // occlusion culling of wall sections, rings, floor and roof on/off
+            occlusionCull=!occlusionCull;
+            cout<<"occlusion culling "<<(occlusionCull? "on" : "off")<<endl;
+            update();
+            break;
+        case Qt::Key_L:
+            // brick lods on/off
+            brickLod=!brickLod;
+            updateBrickLods();
+            makeCurrent();
+            brick.updateInstanceMatBuffers();
+            doneCurrent();
+            break;
+        case Qt::Key_G:
+            // graded (adaptive) brick grid on/off
+            brickAdaptive=!brickAdaptive;
+            rebuildGeometry();
+            break;
+        case Qt::Key_Q:
+            // simplified far lods on/off
+            brickSimplify=!brickSimplify;
+            rebuildGeometry();
+            break;
+        case Qt::Key_N:
+            // new random brick shape
+            brickSeed++;
+            rebuildGeometry();
+            break;
         case Qt::Key_Tab:
             // toggle fly mode
             flyMode=!flyMode;
@@ -1683,7 +2109,7 @@ void GLWidget::create_cube_map_1file(const char* boxbmp,
 
 // load a vertex and fragment shader from a file.
 // I did not write this but I truly can't remember where I found it.
-GLuint GLWidget::loadShaders(const char* vertf, const char* fragf) {
+GLuint GLWidget::loadShaders(const char* vertf, const char* fragf, const char *defines) {
     GLuint program = glCreateProgram();
     // read vertex shader from Qt resource file
     QFile vertFile(vertf);
@@ -1692,6 +2118,10 @@ GLuint GLWidget::loadShaders(const char* vertf, const char* fragf) {
     QTextStream vertStream(&vertFile);
     vertString.append(vertStream.readAll());
     std::string vertSTLString = vertString.toStdString();
+    if(defines){
+        size_t eol=vertSTLString.find('\n');
+        vertSTLString.insert(eol==std::string::npos? vertSTLString.size() : eol+1,defines);
+    }
 
     const GLchar* vertSource = vertSTLString.c_str();
 
@@ -1712,6 +2142,10 @@ GLuint GLWidget::loadShaders(const char* vertf, const char* fragf) {
         }
     }
     glAttachShader(program, vertShader);
+    if(!fragf){
+        glLinkProgram(program);
+        return program;
+    }
     // read fragment shader from Qt resource file
     QFile fragFile(fragf);
     fragFile.open(QFile::ReadOnly | QFile::Text);
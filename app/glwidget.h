@@ -18,6 +18,9 @@
 #include <glm/glm.hpp>
 #include <iostream>
 #include <mesh.h>
+#include "brickbuilder.h"
+#include "explosionsim.h"
+#include "occlusion.h"
 
 
 using glm::mat4;
@@ -77,6 +80,13 @@ class GLWidget : public QOpenGLWidget, protected QOGLVER {
         float brickHeight;
         float brickSpace;
         float brickRough;
+        uint brickSeed;
+        int brickLod;
+        int brickAdaptive;
+        float brickLodNear;
+        float brickLodPixels;   // screen error allowed before a finer lod is drawn
+        int brickSimplify;
+        BrickBuilder brickBuilder;
         float brickRadius;
         int brickFlatShade;
         int bricksPerRow;
@@ -93,7 +103,7 @@ class GLWidget : public QOpenGLWidget, protected QOGLVER {
 
         void rebuildBrick(vec3 col);
         void buildMortar();
-        void rebuildNormalMarks(Mesh mesh);
+        void rebuildNormalMarks(const MeshData &mesh);
         void initAxes();
         void initializeGrid();
         glm::vec2 buildWall(float xs, float zs, float xf, float zf, int isStart, int isFinish, int startHeight, int height, int extMort);
@@ -105,7 +115,6 @@ class GLWidget : public QOpenGLWidget, protected QOGLVER {
         void generateSimpleMortar(float angle, float x, float z, int startRow, int rows, int ext);
         void generateCircularMortar(float radius);
         void scaleBrick();
-        void unScaleBrick();
         void updateWallBuffers();
         void insertBrick(mat4 t);
         void updateLight();
@@ -114,6 +123,12 @@ class GLWidget : public QOpenGLWidget, protected QOGLVER {
         void generateLight();
         void animateRing();
         void brickExplosion();
+        void benchmarkSubdivide();
+        void benchmarkBrickGPU();
+        void benchmarkBuildHouse();
+        QString brickCachePath(const BrickParams &p);
+        bool swapInBrick();
+        void updateBrickLods(int report=0);
 
 
         vec3 spinAxes[NSPINAXES];
@@ -147,11 +162,12 @@ class GLWidget : public QOpenGLWidget, protected QOGLVER {
         glm::vec2 w2dcSquare(const glm::vec2 &pt);
 
     private:
-        GLuint loadShaders(const char* vertf, const char* fragf);
+        // defines go in right after the vertex shader's #version line
+        GLuint loadShaders(const char* vertf, const char* fragf, const char *defines=0);
         unsigned char* loadImg(const char * path, int &x, int &y);
         void initMeshes();
 
-        GLuint programU,programI,programS,programT,programBox;
+        GLuint programU,programI,programS,programT,programBox,programSim;
         GLint projMatrixLocU,projMatrixLocI,projMatrixLocS,projMatrixLocT;
         GLint viewMatrixLocU,viewMatrixLocI,viewMatrixLocS,viewMatrixLocT;
         GLint modelMatrixLocU,modelMatrixLocI,modelMatrixLocS,modelMatrixLocT;
@@ -217,6 +233,22 @@ class GLWidget : public QOpenGLWidget, protected QOGLVER {
         float ringSpeed;
         int ringStart=0,ringStop=0,ringArmed=0,startDay=0,finishDarken=0,finishedBrighten=1;
         int darkenSky=0,brickExplode=0,lightFollow=0,finishedRebuild=0;
+        // the explosion moved by transform feedback, or by the cpu in brickExplosion (X)
+        ExplosionSim explosionSim;
+        int gpuExplosion=1;
+        // brick and mortar instances out of view left out of the draws (C)
+        int cullInstances=1;
+        int paintFrames=0;
+        // wall sections, and the rings, floor and roof, left out while the walls hide them.
+        // A section is one buildWall, its bricks and mortar slab are instance group i and
+        // occlusion box i; the boxes for the other meshes come after the sections (O).
+        OcclusionQueries occlusion;
+        int occlusionCull=1;
+        int wallSections=0;
+        int sectionsChanged=1;
+        std::vector<vec3> sectionLo, sectionHi;
+        void applyOcclusion();
+        void queryOcclusion();
 
         SimpleTexMesh ground;
         SimpleTexMesh floor;
@@ -229,6 +261,8 @@ class GLWidget : public QOpenGLWidget, protected QOGLVER {
 
         LineMesh grid;
         LineMesh normalMarks;
+        // temporary arrays for building the meshes made on this thread, see mesharena.h
+        MeshArena geometryScratch;
         LineMesh axes;
 
         QBasicTimer keyTimer;
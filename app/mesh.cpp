@@ -0,0 +1,998 @@
+
+#include "mesh.h"
+#include "parallelfor.h"
+#include "meshkernels.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/rotate_vector.hpp>
+#include <glm/gtc/random.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <cfloat>
+#include <QFile>
+#include <QElapsedTimer>
+
+
+using glm::inverse;
+using glm::vec2;
+using glm::vec3;
+using glm::vec4;
+using glm::mat3;
+using glm::mat4;
+using glm::perspective;
+using glm::normalize;
+using glm::length;
+using glm::cross;
+using glm::dot;
+using glm::rotate;
+using glm::rotateX;
+using glm::rotateZ;
+using glm::translate;
+using glm::scale;
+using glm::value_ptr;
+using glm::lookAt;
+using std::cout;
+using std::endl;
+using std::vector;
+
+Mesh::Mesh(){
+    modelMatrix=mat4(1.0f);
+    modelMatLoc=normalMatLoc=-1;
+    boundCenter=boundLo=boundHi=vec3(0,0,0);
+    boundRadius=0;
+    packedVertices=0;
+    uploadedPacked=0;
+    packedSaved=0;
+    material.shinyness=100;
+    material.diffuse=.8f;
+    material.specular=.7f;
+    material.ambient=.2f;
+    material.specColor=vec3(1,1,1);
+    material.atten=.2f;
+    material.attenS=.2f;
+    material.glow=0;
+    material.flatShade=0;
+}
+Mesh::~Mesh(){
+
+}
+
+// Vertices go to the GPU interleaved in one buffer, buffers[0]: position, color, normal,
+// then uv for SimpleTexMesh. buffers[3] holds the indices.
+static const GLsizei VERTEX_STRIDE=3*sizeof(vec3);
+
+// Packed vertex, 16 bytes instead of 36: half float position (w=1), normal as signed
+// 10:10:10:2, color as RGBA8. Colors are clamped to [0,1].
+struct PackedVertex{
+    glm::uint64 pos;
+    glm::uint32 normal;
+    glm::uint32 color;
+};
+
+// meshes with at least this many triangles get reordered before their first upload
+#define OPTIMIZE_MIN_TRIS 1024
+
+void Mesh::updateBuffers(){
+    if(needsOptimize && idx.size()/3>=OPTIMIZE_MIN_TRIS)
+        optimize();
+    needsOptimize=0;
+
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+    uploadVertices(0);
+}
+
+void Mesh::uploadVertices(const vec2 *uv){
+    uint n=pts.size();
+    bool packed=packedVertices && !uv;
+    GLsizei stride=packed? sizeof(PackedVertex) : uv? VERTEX_STRIDE+sizeof(vec2) : VERTEX_STRIDE;
+    GLsizeiptr size=(GLsizeiptr)n*stride;
+    packedSaved= packed? (GLsizeiptr)n*VERTEX_STRIDE-size : 0;
+
+    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[3]);
+    gl->glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size()*sizeof(GLuint),idx.data(),GL_DYNAMIC_DRAW);
+
+    boundingSphere(boundCenter,boundRadius);
+    boundingBox(boundLo,boundHi);
+
+    gl->glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    gl->glBufferData(GL_ARRAY_BUFFER, size, 0, GL_DYNAMIC_DRAW);
+    if(n==0)
+        return;
+    char *dst=(char*)gl->glMapBufferRange(GL_ARRAY_BUFFER, 0, size,
+                                          GL_MAP_WRITE_BIT|GL_MAP_INVALIDATE_BUFFER_BIT);
+    if(!dst){
+        cout<<"could not map vertex buffer"<<endl;
+        return;
+    }
+    // meshes that never got colors or normals upload zeros for them
+    const vec3 *c=colors.size()==n? colors.data() : 0;
+    const vec3 *nr=normals.size()==n? normals.data() : 0;
+    const vec3 *p=pts.data();
+    parallelFor(n,16384,[&](uint v0,uint v1){
+        vec3 zero(0.0f);
+        for(uint i=v0;i<v1;i++){
+            if(packed){
+                PackedVertex *v=(PackedVertex*)dst+i;
+                v->pos=glm::packHalf4x16(vec4(p[i],1));
+                v->normal=glm::packSnorm3x10_1x2(vec4(nr? nr[i] : zero,0));
+                v->color=glm::packUnorm4x8(vec4(c? c[i] : zero,1));
+                continue;
+            }
+            vec3 *v=(vec3*)(dst+(size_t)i*stride);
+            v[0]=p[i];
+            v[1]=c? c[i] : zero;
+            v[2]=nr? nr[i] : zero;
+            if(uv)
+                *(vec2*)(v+3)=uv[i];
+        }
+    });
+    gl->glUnmapBuffer(GL_ARRAY_BUFFER);
+
+    // switching format only needs the attribute pointers redone
+    if(packed!=uploadedPacked){
+        if(packed)
+            setupPackedVertexAttribs();
+        else
+            setupVertexAttribs(stride);
+        uploadedPacked=packed;
+    }
+}
+
+void Mesh::setupPackedVertexAttribs(){
+    gl->glBindBuffer(GL_ARRAY_BUFFER,buffers[0]);
+    GLsizei stride=sizeof(PackedVertex);
+    gl->glVertexAttribPointer(index[0], 4, GL_HALF_FLOAT, GL_FALSE, stride,(void*)offsetof(PackedVertex,pos));
+    gl->glVertexAttribPointer(index[1], 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,(void*)offsetof(PackedVertex,color));
+    gl->glVertexAttribPointer(index[2], 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,(void*)offsetof(PackedVertex,normal));
+}
+
+// position/color/normal attributes out of the interleaved buffer, stride is the whole vertex
+void Mesh::setupVertexAttribs(GLsizei stride){
+    gl->glBindBuffer(GL_ARRAY_BUFFER,buffers[0]);
+    for(int i=0;i<3;i++){
+        index[i]=gl->glGetAttribLocation(program,names[i]);
+        gl->glVertexAttribPointer(index[i], 3, GL_FLOAT, GL_FALSE, stride,(void*)(i*sizeof(vec3)));
+        gl->glEnableVertexAttribArray(index[i]);
+    }
+}
+
+void Mesh::init(QOGLVER* context){
+    gl=context;
+}
+
+void Mesh::initialize(GLuint program, GLint alphaLoc,
+                      GLint aLoc, GLint sLoc, GLint dLoc,
+                      GLint sColLoc, GLint atLoc, GLint atSLoc, GLint glowLoc){
+    material.alphaLoc=alphaLoc;
+    material.kaloc=aLoc;
+    material.ksloc=sLoc;
+    material.kdloc=dLoc;
+    material.spcolloc=sColLoc;
+    material.attenLoc=atLoc;
+    material.attenSLoc=atSLoc;
+    material.glowLoc=glowLoc;
+    gl->glGenVertexArrays(1,&vao);
+    this->program=program;
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+    gl->glGenBuffers(4,buffers);
+    setupVertexAttribs(VERTEX_STRIDE);
+    modelMatLoc=gl->glGetUniformLocation(program,"model");
+    normalMatLoc=gl->glGetUniformLocation(program,"modelNormal");
+    material.flatLoc=gl->glGetUniformLocation(program,"flatShade");
+}
+
+void Mesh::worldBox(vec3 &lo, vec3 &hi) const {
+    lo=vec3(modelMatrix[3]);
+    hi=lo;
+    for(int c=0;c<3;c++){
+        vec3 a=vec3(modelMatrix[c])*boundLo[c];
+        vec3 b=vec3(modelMatrix[c])*boundHi[c];
+        lo+=glm::min(a,b);
+        hi+=glm::max(a,b);
+    }
+}
+
+// the normal matrix is worked out here once per draw rather than in the shader once per
+// vertex, the view that goes on top of it is rigid
+void Mesh::setModelUniforms(){
+    gl->glUniformMatrix4fv(modelMatLoc,1,false,value_ptr(modelMatrix));
+    mat3 normalMat=glm::transpose(inverse(mat3(modelMatrix)));
+    gl->glUniformMatrix3fv(normalMatLoc,1,false,value_ptr(normalMat));
+}
+
+void Mesh::render(){
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+    setModelUniforms();
+
+    gl->glUniform1f(material.alphaLoc,material.shinyness);
+    gl->glUniform1f(material.kdloc,material.diffuse);
+    gl->glUniform1f(material.ksloc,material.specular);
+    gl->glUniform1f(material.kaloc,material.ambient);
+    gl->glUniform3fv(material.spcolloc,1,value_ptr(material.specColor));
+    gl->glUniform1f(material.attenLoc,material.atten);
+    gl->glUniform1f(material.attenSLoc,material.attenS);
+    gl->glUniform1f(material.glowLoc,material.glow);
+    gl->glUniform1i(material.flatLoc,material.flatShade);
+
+    // lod 0 starts at the beginning of the buffers
+    gl->glDrawElements(GL_TRIANGLES,lods.empty()? idx.size() : lods[0].nIdx,GL_UNSIGNED_INT,0);
+}
+void Mesh::renderTest(){
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+    setModelUniforms();
+//    gl->glDrawElements(GL_TRIANGLES,idx.size(),GL_UNSIGNED_INT,0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// the scale is the length of each axis, the rotation what's left of the axes without it.
+// A mirrored matrix keeps its mirror in scale.x.
+InstanceXform::InstanceXform(const mat4 &m){
+    vec3 ax(m[0]),ay(m[1]),az(m[2]);
+    pos=vec3(m[3]);
+    scale=vec3(glm::length(ax),glm::length(ay),glm::length(az));
+    if(glm::dot(glm::cross(ax,ay),az)<0)
+        scale.x=-scale.x;
+    rot=glm::normalize(glm::quat_cast(glm::mat3(ax/scale.x,ay/scale.y,az/scale.z)));
+}
+
+mat4 InstanceXform::toMat4() const {
+    mat4 m=glm::mat4_cast(rot);
+    m[0]*=scale.x;
+    m[1]*=scale.y;
+    m[2]*=scale.z;
+    m[3]=vec4(pos,1);
+    return m;
+}
+
+// Packed instance, 28 bytes instead of a 64 byte mat4: float position (half floats would
+// put bricks a few hundredths off at the edge of the scene), the rotation quaternion and
+// the scale as half floats. vert_instanced.glsl builds the matrix back from them.
+struct PackedInstance{
+    float pos[3];
+    glm::uint32 rot[2];     // x,y,z,w
+    glm::uint32 scale[2];   // x,y,z, and one unused
+};
+
+static void packInstances(const InstanceXform *x, const uint *order, uint n, PackedInstance *out){
+    parallelFor(n,16384,[&](uint i0,uint i1){
+        for(uint i=i0;i<i1;i++){
+            const InstanceXform &s=x[order? order[i] : i];
+            PackedInstance &p=out[i];
+            p.pos[0]=s.pos.x;
+            p.pos[1]=s.pos.y;
+            p.pos[2]=s.pos.z;
+            glm::uint64 r=glm::packHalf4x16(vec4(s.rot.x,s.rot.y,s.rot.z,s.rot.w));
+            glm::uint64 k=glm::packHalf4x16(vec4(s.scale,0));
+            memcpy(p.rot,&r,sizeof(r));
+            memcpy(p.scale,&k,sizeof(k));
+        }
+    });
+}
+
+InstancedMesh::InstancedMesh(){
+    material.shinyness=100;
+    material.diffuse=.8f;
+    material.specular=.7f;
+    material.ambient=.2f;
+    material.specColor=vec3(1,1,1);
+    viewPos=vec3(0,0,0);
+    batchDepth=0;
+    external=0;
+    culling=0;
+    instancesChanged=1;
+    currentGroup=0;
+    culledInstances=culledSum=cullFrames=0;
+    streaming=0;
+    streamRegion=0;
+    regionBytes=0;
+    instanceBase=0;
+    for(int i=0;i<INSTANCE_REGIONS;i++)
+        regionFence[i]=0;
+    streamUploads=streamStalls=0;
+    streamStallMs=0;
+}
+
+void InstancedMesh::initialize(GLuint program, GLint alphaLoc,
+                               GLint aLoc, GLint sLoc, GLint dLoc,
+                               GLint sColLoc, GLint atLoc, GLint atSLoc, GLint glowLoc){
+    material.alphaLoc=alphaLoc;
+    material.kaloc=aLoc;
+    material.ksloc=sLoc;
+    material.kdloc=dLoc;
+    material.spcolloc=sColLoc;
+    material.attenLoc=atLoc;
+    material.attenSLoc=atSLoc;
+    material.glowLoc=glowLoc;
+    gl->glGenVertexArrays(1,&vao);
+    this->program=program;
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+    gl->glGenBuffers(4,buffers);
+    setupVertexAttribs(VERTEX_STRIDE);
+
+    gl->glGenBuffers(1,&instanceBuf);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, instanceBuf);
+    instancePosLoc=gl->glGetAttribLocation(program,"instancePos");
+    instanceRotLoc=gl->glGetAttribLocation(program,"instanceRot");
+    instanceScaleLoc=gl->glGetAttribLocation(program,"instanceScale");
+    GLint locs[3]={instancePosLoc,instanceRotLoc,instanceScaleLoc};
+    for(int i=0;i<3;i++){
+        gl->glEnableVertexAttribArray(locs[i]);
+        gl->glVertexAttribDivisor(locs[i],1);
+    }
+    setInstanceOffset(0);
+
+    modelMatLoc=gl->glGetUniformLocation(program,"model");
+    normalMatLoc=gl->glGetUniformLocation(program,"modelNormal");
+    material.flatLoc=gl->glGetUniformLocation(program,"flatShade");
+}
+
+void InstancedMesh::beginInstances(uint expected){
+    batchDepth++;
+    // no smaller steps than push_back would take, nested batches each ask for a bit more
+    size_t need=instances.size()+expected;
+    if(need>instances.capacity()){
+        need=std::max(need,instances.capacity()*2);
+        instances.reserve(need);
+        instanceGroup.reserve(need);
+        instanceVel.reserve(need);
+        instanceOnGround.reserve(need);
+    }
+}
+
+void InstancedMesh::commitInstances(){
+    if(batchDepth>0 && --batchDepth==0){
+        if(culling)
+            sortInstancesMorton();
+        updateInstanceMatBuffers();
+    }
+}
+
+void InstancedMesh::addInstance(const InstanceXform &x){
+    instances.push_back(x);
+    instanceGroup.push_back(currentGroup);
+    if(!batchDepth)
+        updateInstanceMatBuffers();
+
+    vec3 pos=x.pos;
+    glm::normalize(pos);
+    pos*=.01;
+    pos.y+=glm::linearRand(.1f,.3f);
+    pos.x+=glm::gaussRand(0.0f,.001f);
+    pos.z+=glm::gaussRand(0.0f,.001f);
+    instanceVel.push_back(pos);
+    instanceOnGround.push_back(0);
+}
+void InstancedMesh::render(){
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+
+    gl->glUniform1f(material.alphaLoc,material.shinyness);
+    gl->glUniform1f(material.kdloc,material.diffuse);
+    gl->glUniform1f(material.ksloc,material.specular);
+    gl->glUniform1f(material.kaloc,material.ambient);
+    gl->glUniform1f(material.attenLoc,material.atten);
+    gl->glUniform1f(material.attenSLoc,material.attenS);
+    gl->glUniform1f(material.glowLoc,material.glow);
+    gl->glUniform1i(material.flatLoc,material.flatShade);
+    gl->glUniform3fv(material.spcolloc,1,value_ptr(material.specColor));
+
+    setModelUniforms();
+    drawInstances();
+}
+
+void InstancedMesh::drawInstances(){
+    gl->glBindVertexArray(vao);
+    if(external){
+        gl->glDrawElementsInstanced(GL_TRIANGLES,lods.empty()? idx.size() : lods[0].nIdx,
+                                    GL_UNSIGNED_INT,0,instances.size());
+        return;
+    }
+    // culled, only the instances in view go in the buffer, in their order
+    const uint *order=0;
+    uint n=instances.size();
+    if(culling){
+        n=cullInstances();
+        order=visible.data();
+    }
+    if(!drawsLods()){
+        // the same instances as last time are already there
+        if(culling && (instancesChanged || visible!=uploadedVisible)){
+            uploadInstances(order,n);
+            uploadedVisible=visible;
+            instancesChanged=0;
+        }
+        setInstanceOffset(instanceBase);
+        gl->glDrawElementsInstanced(GL_TRIANGLES,lods.empty()? idx.size() : lods[0].nIdx,
+                                    GL_UNSIGNED_INT,0,n);
+    }else{
+
+    // one draw per lod over its slice of the sorted instance buffer. There is no base
+    // instance in GL 3.3, so the instance attribute is re-pointed at the slice instead.
+        bucketInstances(order,n);
+        uint first=0;
+        for(uint l=0;l<lods.size();l++){
+            if(lodInstances[l]){
+                setInstanceOffset(instanceBase+first*sizeof(PackedInstance));
+                gl->glDrawElementsInstanced(GL_TRIANGLES,lods[l].nIdx,GL_UNSIGNED_INT,
+                                            (void*)(lods[l].firstIdx*sizeof(GLuint)),lodInstances[l]);
+            }
+            first+=lodInstances[l];
+        }
+        setInstanceOffset(instanceBase);
+    }
+
+    // the slice can be written again once the gpu is past this point
+    if(streaming){
+        GLsync &f=regionFence[streamRegion];
+        if(f)
+            gl->glDeleteSync(f);
+        f=gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+    }
+}
+
+// counting sort of the instances by lod, uploaded in lodOrder
+void InstancedMesh::bucketInstances(const uint *order, uint n){
+    uint nLods=lods.size();
+    instanceLod.resize(n);
+    lodInstances.assign(nLods,0);
+    for(uint i=0;i<n;i++){
+        vec3 d=instances[order? order[i] : i].pos-viewPos;
+        float d2=dot(d,d);
+        uint l=0;
+        while(l+1<nLods && l<lodDist.size() && d2>lodDist[l]*lodDist[l])
+            l++;
+        instanceLod[i]=l;
+        lodInstances[l]++;
+    }
+    vector<uint> next(nLods,0);
+    for(uint l=1;l<nLods;l++)
+        next[l]=next[l-1]+lodInstances[l-1];
+    lodOrder.resize(n);
+    for(uint i=0;i<n;i++)
+        lodOrder[next[instanceLod[i]]++]=order? order[i] : i;
+
+    uploadInstances(lodOrder.data(),n);
+}
+
+// Without streaming the whole buffer is replaced. Streaming, each upload goes to the next
+// slice round the ring, mapped unsynchronized so the driver never waits for the gpu
+// itself. The fence set after the draws that last read that slice, a couple of frames
+// ago, has normally passed by then: the cpu writes frame N+1 while the gpu still reads
+// frame N. If it hasn't passed the upload waits for it, and that counts as a stall.
+void InstancedMesh::uploadInstances(const uint *order, uint n){
+    gl->glBindBuffer(GL_ARRAY_BUFFER, instanceBuf);
+    size_t bytes=n*sizeof(PackedInstance);
+    if(!streaming){
+        packScratch.resize(bytes);
+        packInstances(instances.data(),order,n,(PackedInstance*)packScratch.data());
+        gl->glBufferData(GL_ARRAY_BUFFER,bytes,packScratch.data(),GL_DYNAMIC_DRAW);
+        instanceBase=0;
+        return;
+    }
+
+    streamUploads++;
+    if(bytes>regionBytes){
+        // orphan the old storage for a bigger one, the driver keeps the old one around
+        // until the gpu is done with it, so nothing needs waiting for
+        regionBytes=std::max(bytes,std::max(regionBytes*2,(size_t)256*sizeof(PackedInstance)));
+        for(int i=0;i<INSTANCE_REGIONS;i++){
+            if(regionFence[i])
+                gl->glDeleteSync(regionFence[i]);
+            regionFence[i]=0;
+        }
+        gl->glBufferData(GL_ARRAY_BUFFER,regionBytes*INSTANCE_REGIONS,0,GL_STREAM_DRAW);
+    }
+
+    streamRegion=(streamRegion+1)%INSTANCE_REGIONS;
+    GLsync &f=regionFence[streamRegion];
+    if(f){
+        if(gl->glClientWaitSync(f,0,0)==GL_TIMEOUT_EXPIRED){
+            QElapsedTimer t;
+            t.start();
+            while(gl->glClientWaitSync(f,GL_SYNC_FLUSH_COMMANDS_BIT,1000000)==GL_TIMEOUT_EXPIRED)
+                ;
+            streamStalls++;
+            streamStallMs+=t.nsecsElapsed()/1e6;
+        }
+        gl->glDeleteSync(f);
+        f=0;
+    }
+
+    instanceBase=streamRegion*regionBytes;
+    if(!bytes)
+        return;
+    void *dst=gl->glMapBufferRange(GL_ARRAY_BUFFER,instanceBase,bytes,
+                                   GL_MAP_WRITE_BIT|GL_MAP_INVALIDATE_RANGE_BIT|GL_MAP_UNSYNCHRONIZED_BIT);
+    if(!dst){
+        cout<<"could not map the instance buffer"<<endl;
+        return;
+    }
+    packInstances(instances.data(),order,n,(PackedInstance*)dst);
+    gl->glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+void InstancedMesh::setStreaming(int s){
+    streaming=s;
+    for(int i=0;i<INSTANCE_REGIONS;i++){
+        if(regionFence[i])
+            gl->glDeleteSync(regionFence[i]);
+        regionFence[i]=0;
+    }
+    // the next upload sizes the buffer for whichever way it is now
+    regionBytes=0;
+    instanceBase=0;
+}
+
+void InstancedMesh::reportStreaming(){
+    cout<<"instance stream: "<<streamUploads<<" uploads, "<<streamStalls<<" waited for the gpu, "
+        <<streamStallMs<<" ms waiting"<<endl;
+    streamUploads=streamStalls=0;
+    streamStallMs=0;
+}
+
+// points the instance attributes at the packed instances starting offset bytes into the
+// buffer
+void InstancedMesh::setInstanceOffset(size_t offset){
+    gl->glBindBuffer(GL_ARRAY_BUFFER, instanceBuf);
+    GLsizei stride=sizeof(PackedInstance);
+    gl->glVertexAttribPointer(instancePosLoc, 3, GL_FLOAT, GL_FALSE, stride,
+                              (void*)(offset+offsetof(PackedInstance,pos)));
+    gl->glVertexAttribPointer(instanceRotLoc, 4, GL_HALF_FLOAT, GL_FALSE, stride,
+                              (void*)(offset+offsetof(PackedInstance,rot)));
+    gl->glVertexAttribPointer(instanceScaleLoc, 3, GL_HALF_FLOAT, GL_FALSE, stride,
+                              (void*)(offset+offsetof(PackedInstance,scale)));
+}
+void InstancedMesh::setExternalInstances(int e){
+    if(external==e)
+        return;
+    external=e;
+    if(!external){
+        gl->glBindVertexArray(vao);
+        updateInstanceMatBuffers();
+        setInstanceOffset(instanceBase);
+    }
+}
+
+void InstancedMesh::setCulling(int c){
+    if(culling==c)
+        return;
+    culling=c;
+    instancesChanged=1;
+    if(culling)
+        sortInstancesMorton();
+    else
+        updateInstanceMatBuffers();
+}
+
+// each instance's sphere is the mesh's, moved by modelMatrix and then by the instance.
+// It's redone every frame, the bricks move when they explode.
+uint InstancedMesh::cullInstances(){
+    uint n=instances.size();
+    sphereX.resize(n);
+    sphereY.resize(n);
+    sphereZ.resize(n);
+    sphereR.resize(n);
+    visible.resize(n);
+
+    vec3 c=vec3(modelMatrix*vec4(boundCenter,1));
+    float r=boundRadius*std::max(length(vec3(modelMatrix[0])),
+                                 std::max(length(vec3(modelMatrix[1])),length(vec3(modelMatrix[2]))));
+    const InstanceXform *x=instances.data();
+    parallelFor(n,16384,[&](uint i0,uint i1){
+        for(uint i=i0;i<i1;i++){
+            vec3 s=glm::abs(x[i].scale);
+            vec3 p=x[i].pos+x[i].rot*(x[i].scale*c);
+            sphereX[i]=p.x;
+            sphereY[i]=p.y;
+            sphereZ[i]=p.z;
+            sphereR[i]=r*std::max(s.x,std::max(s.y,s.z));
+        }
+    });
+
+    vec4 planes[6];
+    frustumPlanes(viewProj,planes);
+    uint nVis=cullSpheres(sphereX.data(),sphereY.data(),sphereZ.data(),sphereR.data(),n,planes,visible.data());
+    if(!groupHidden.empty()){
+        uint k=0;
+        for(uint j=0;j<nVis;j++){
+            uint g=instanceGroup[visible[j]];
+            if(g>=groupHidden.size() || !groupHidden[g])
+                visible[k++]=visible[j];
+        }
+        nVis=k;
+    }
+    visible.resize(nVis);
+    culledInstances=n-nVis;
+    culledSum+=culledInstances;
+    cullFrames++;
+    return nVis;
+}
+
+void InstancedMesh::setGroupHidden(uint g, int hidden){
+    if(g>=groupHidden.size()){
+        if(!hidden)
+            return;
+        groupHidden.resize(g+1,0);
+    }
+    groupHidden[g]=hidden;
+}
+
+void InstancedMesh::groupBounds(vector<vec3> &lo, vector<vec3> &hi){
+    uint nGroups=0;
+    for(uint i=0;i<instanceGroup.size();i++)
+        nGroups=std::max(nGroups,instanceGroup[i]+1);
+    lo.assign(nGroups,vec3(FLT_MAX));
+    hi.assign(nGroups,vec3(-FLT_MAX));
+
+    // the mesh's box after modelMatrix, as a middle and half sizes
+    vec3 mlo,mhi;
+    worldBox(mlo,mhi);
+    vec3 c=(mlo+mhi)*.5f, e=(mhi-mlo)*.5f;
+    for(uint i=0;i<instances.size();i++){
+        const InstanceXform &x=instances[i];
+        glm::mat3 m=glm::mat3_cast(x.rot);
+        vec3 p=x.pos+m*(x.scale*c);
+        // half sizes of the turned and scaled box: |m*scale| times e
+        vec3 h(0,0,0);
+        for(int k=0;k<3;k++)
+            h+=glm::abs(m[k]*x.scale[k])*e[k];
+        uint g=instanceGroup[i];
+        lo[g]=glm::min(lo[g],p-h);
+        hi[g]=glm::max(hi[g],p+h);
+    }
+}
+
+void InstancedMesh::reportCulling(const char *name){
+    if(!cullFrames)
+        return;
+    cout<<name<<": "<<culledSum/(float)cullFrames<<" of "<<instances.size()
+        <<" instances culled per frame, over "<<cullFrames<<" frames"<<endl;
+    culledSum=cullFrames=0;
+}
+
+// by the Morton code of each position in the box around all of them, carrying the
+// velocities, ground flags and groups along
+void InstancedMesh::sortInstancesMorton(){
+    uint n=instances.size();
+    // whoever draws them from outside keeps its own copy in the old order
+    if(n<2 || external)
+        return;
+    vec3 lo=instances[0].pos,hi=lo;
+    for(uint i=1;i<n;i++){
+        lo=glm::min(lo,instances[i].pos);
+        hi=glm::max(hi,instances[i].pos);
+    }
+    vec3 inv=1.0f/glm::max(hi-lo,vec3(1e-6f));
+    vector<std::pair<uint,uint> > keys(n);
+    for(uint i=0;i<n;i++)
+        keys[i]=std::make_pair(mortonCode((instances[i].pos-lo)*inv),i);
+    std::sort(keys.begin(),keys.end());
+
+    vector<InstanceXform> xs(n);
+    vector<vec3> vels(n);
+    vector<int> ground(n);
+    vector<uint> groups(n);
+    for(uint i=0;i<n;i++){
+        uint k=keys[i].second;
+        xs[i]=instances[k];
+        vels[i]=instanceVel[k];
+        ground[i]=instanceOnGround[k];
+        groups[i]=instanceGroup[k];
+    }
+    instances.swap(xs);
+    instanceGroup.swap(groups);
+    instanceVel.swap(vels);
+    instanceOnGround.swap(ground);
+    instancesChanged=1;
+}
+
+void InstancedMesh::clearInstances(){
+    instances.clear();
+    instanceGroup.clear();
+    instanceVel.clear();
+    instanceOnGround.clear();
+    instancesChanged=1;
+}
+
+void InstancedMesh::updateInstanceMatBuffers(){
+    // with lods or culling the buffer holds the sorted or culled copy, made in render()
+    if(drawsLods() || external || culling){
+        instancesChanged=1;
+        return;
+    }
+    gl->glBindVertexArray(vao);
+    uploadInstances(0,instances.size());
+}
+int InstancedMesh::getNumInstances(){
+    return instances.size();
+}
+
+mat4 InstancedMesh::getInstanceMat(uint i){
+    if(instances.size()==0 || i>instances.size()-1){
+        cout<<"no instances in getInstanceMat"<<endl;
+        return mat4(1.0f);
+    }
+    return instances[i].toMat4();
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+
+void LineMesh::initialize(GLuint program){
+    gl->glGenVertexArrays(1,&vao);
+    this->program=program;
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+    gl->glGenBuffers(2,buffers);
+    for(int i=0;i<2;i++){
+        gl->glBindBuffer(GL_ARRAY_BUFFER,buffers[i]);
+        index[i]=gl->glGetAttribLocation(program,names[i]);
+        gl->glEnableVertexAttribArray(index[i]);
+        gl->glVertexAttribPointer(index[i], 3, GL_FLOAT, GL_FALSE, 0,0);
+    }
+    modelMatLoc=gl->glGetUniformLocation(program,"model");
+}
+void LineMesh::updateBuffers(){
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+    gl->glBindBuffer(GL_ARRAY_BUFFER,buffers[0]);
+    gl->glBufferData(GL_ARRAY_BUFFER, pts.size()*sizeof(vec3), &pts[0], GL_STATIC_DRAW);
+    gl->glBindBuffer(GL_ARRAY_BUFFER,buffers[1]);
+    gl->glBufferData(GL_ARRAY_BUFFER, colors.size()*sizeof(vec3), &colors[0], GL_STATIC_DRAW);
+}
+void LineMesh::render(){
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+    gl->glUniformMatrix4fv(modelMatLoc,1,false,value_ptr(modelMatrix));
+    gl->glDrawArrays(GL_LINES,0,pts.size());
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+
+
+void SimpleTexMesh::initialize(GLuint program, GLuint slot, const char* file, GLint alphaLoc,
+                               GLint aLoc, GLint sLoc, GLint dLoc,
+                               GLint sColLoc, GLint atLoc, GLint atSLoc, GLint glowLoc, GLint sampLoc, GLint magParam){
+    texSlot=slot;
+
+    material.alphaLoc=alphaLoc;
+    material.kaloc=aLoc;
+    material.ksloc=sLoc;
+    material.kdloc=dLoc;
+    material.spcolloc=sColLoc;
+    material.attenLoc=atLoc;
+    material.attenSLoc=atSLoc;
+    material.glowLoc=glowLoc;
+
+
+    gl->glGenTextures(1,&texOb);
+    gl->glActiveTexture(GL_TEXTURE0+texSlot);
+    gl->glBindTexture(GL_TEXTURE_2D,texOb);
+    gl->glEnable(GL_TEXTURE_2D);
+    gl->glUniform1i(sampLoc,texSlot);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magParam);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    gl->glGenVertexArrays(1,&vao);
+    this->program=program;
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+    gl->glGenBuffers(4,buffers);
+    setupVertexAttribs(VERTEX_STRIDE+sizeof(vec2));
+    modelMatLoc=gl->glGetUniformLocation(program,"model");
+    normalMatLoc=gl->glGetUniformLocation(program,"modelNormal");
+
+
+    // uv rides along at the end of each vertex in buffers[0]
+    uvIndex=gl->glGetAttribLocation(program, "uv");
+    gl->glEnableVertexAttribArray(uvIndex);
+    gl->glVertexAttribPointer(uvIndex,2,GL_FLOAT,GL_FALSE,VERTEX_STRIDE+sizeof(vec2),(void*)VERTEX_STRIDE);
+
+
+    loadBMP(file);
+}
+
+void SimpleTexMesh::updateBuffers(){
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+    if(uvs.size()!=pts.size()){
+        cout<<"SimpleTexMesh: "<<uvs.size()<<" uvs for "<<pts.size()<<" vertices"<<endl;
+        uvs.resize(pts.size());
+    }
+    uploadVertices(uvs.data());
+}
+void SimpleTexMesh::render(){
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+
+    gl->glBindTexture(GL_TEXTURE_2D,texOb);
+
+    setModelUniforms();
+
+    gl->glUniform1f(material.alphaLoc,material.shinyness);
+    gl->glUniform1f(material.kdloc,material.diffuse);
+    gl->glUniform1f(material.ksloc,material.specular);
+    gl->glUniform1f(material.kaloc,material.ambient);
+    gl->glUniform3fv(material.spcolloc,1,value_ptr(material.specColor));
+    gl->glUniform1f(material.attenLoc,material.atten);
+    gl->glUniform1f(material.attenSLoc,material.attenS);
+    gl->glUniform1f(material.glowLoc,material.glow);
+
+    gl->glDrawElements(GL_TRIANGLES,idx.size(),GL_UNSIGNED_INT,0);
+}
+
+void SimpleTexMesh::clearVertices(){
+    pts.clear();
+    colors.clear();
+    normals.clear();
+    idx.clear();
+    uvs.clear();
+}
+
+void SimpleTexMesh::generateCube(float texScale){
+    vec3 parray[] = {
+        // top
+        vec3(1,1,1),    // 0
+        vec3(1,1,-1),   // 1
+        vec3(-1,1,-1),  // 2
+        vec3(-1,1,1),   // 3
+
+        // bottom
+        vec3(1,-1,1),   // 4
+        vec3(-1,-1,1),  // 5
+        vec3(-1,-1,-1), // 6
+        vec3(1,-1,-1),  // 7
+
+        // front
+        vec3(1,1,1),    // 8
+        vec3(-1,1,1),   // 9
+        vec3(-1,-1,1),  // 10
+        vec3(1,-1,1),   // 11
+
+        // back
+        vec3(-1,-1,-1), // 12
+        vec3(-1,1,-1),  // 13
+        vec3(1,1,-1),   // 14
+        vec3(1,-1,-1),  // 15
+
+        // right
+        vec3(1,-1,1),   // 16
+        vec3(1,-1,-1),  // 17
+        vec3(1,1,-1),   // 18
+        vec3(1,1,1),     // 19
+
+        // left
+        vec3(-1,-1,1),  // 20
+        vec3(-1,1,1),   // 21
+        vec3(-1,1,-1),  // 22
+        vec3(-1,-1,-1) // 23
+
+    };
+    vec2 uvarray[]={
+        vec2(0,1),
+        vec2(0,0),
+        vec2(1,0),
+        vec2(1,1),
+
+        vec2(0,1),
+        vec2(0,0),
+        vec2(1,0),
+        vec2(1,1),
+
+        vec2(1,1),
+        vec2(1,0),
+        vec2(0,0),
+        vec2(0,1),
+
+        vec2(0,1),
+        vec2(0,0),
+        vec2(1,0),
+        vec2(1,1),
+
+        vec2(1,1),
+        vec2(1,0),
+        vec2(0,0),
+        vec2(0,1),
+
+        vec2(0,1),
+        vec2(0,0),
+        vec2(1,0),
+        vec2(1,1)};
+    for(int i=0;i<24;i++)
+        uvarray[i]*=texScale;
+
+
+    GLuint indices[] = {0,1,3,3,1,2,
+                        4,5,7,7,5,6,
+                        8,9,11,11,9,10,
+                        12,13,15,15,13,14,
+                        16,17,19,19,17,18,
+                        20,21,23,23,21,22};
+
+    pts.insert(pts.end(),&parray[0],&parray[24]);
+    uvs.insert(uvs.end(),&uvarray[0],&uvarray[24]);
+    idx.insert(idx.end(),&indices[0],&indices[36]);
+    normals.insert(normals.end(),&parray[0],&parray[24]);
+    computeNormals(1);
+}
+
+void SimpleTexMesh::scale(vec3 s, int bScaleTexture){
+    Mesh::scale(s);
+    if(bScaleTexture)
+        for(uint i=0;i<uvs.size();i++){
+            if(glm::abs(normals[i].y)>.3f)
+                uvs[i]*=vec2(s.x,s.z);
+            else if(glm::abs(normals[i].z)>.3f)
+                uvs[i]*=vec2(s.x,s.y);
+            else if(glm::abs(normals[i].x)>.3f)
+                uvs[i]*=vec2(s.y,s.z);
+        }
+}
+void SimpleTexMesh::scale(float s, int bScaleTexture){
+    Mesh::scale(s);
+    if(bScaleTexture){
+        for(uint i=0;i<uvs.size();i++){
+            uvs[i].x*=s;
+        }
+    }
+}
+
+GLuint SimpleTexMesh::loadBMP(const char * imagepath){
+    // Data read from the header of the BMP file
+    char header[54];
+    unsigned int width, height;
+    unsigned int imageSize;
+
+
+
+    // Open the file
+    QFile vertFile(imagepath);
+    if(!vertFile.open(QFile::ReadOnly)){
+        cout<<"could not open image\n";
+        return 0;
+    }
+
+
+    if(vertFile.read(header,54) != 54){
+        cout<<"Not a correct BMP file\n";
+        return 0;
+    }
+
+    // Read ints from the byte array
+    imageSize = header[0x22]  | ( (int)header[0x23] << 8 )
+                        | ( (int)header[0x24] << 16 )
+                        | ( (int)header[0x25] << 24 );
+    width = header[0x12]  | ( (int)header[0x13] << 8 )
+                        | ( (int)header[0x14] << 16 )
+                        | ( (int)header[0x15] << 24 );
+    height = header[0x16]  | ( (int)header[0x17] << 8 )
+                        | ( (int)header[0x18] << 16 )
+                        | ( (int)header[0x19] << 24 );
+
+    // Create a buffer
+    char* data = new char [imageSize];
+
+    vertFile.read(data,imageSize);
+
+    vertFile.close();
+
+    gl->glTexImage2D(GL_TEXTURE_2D, 0,GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, data);
+    gl->glGenerateMipmap(GL_TEXTURE_2D);
+
+    delete data;
+    return texOb;
+}
+
+
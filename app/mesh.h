@@ -0,0 +1,247 @@
+#ifndef MESH_H
+#define MESH_H
+
+#define QOGLVER QOpenGLFunctions_3_3_Core
+
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QMouseEvent>
+#include "meshdata.h"
+#include <glm/gtc/quaternion.hpp>
+
+enum MeshType{ARRAY, INDEXED  };
+
+class Material{
+    public:
+        float shinyness;
+        float specular;
+        float diffuse;
+        float ambient;
+        float atten;
+        float attenS;
+        float glow;
+        vec3 specColor;
+        int flatShade;      // faceted look from the fragment shader, the mesh stays indexed
+        GLint alphaLoc,kdloc,ksloc,kaloc,spcolloc,attenLoc,attenSLoc,glowLoc,flatLoc;
+};
+
+
+// GL side of a mesh: buffers, vao, shader and material, drawing whatever geometry the
+// MeshData part holds. The geometry itself is all in MeshData.
+class Mesh : public MeshData
+{
+    public:
+        Mesh();
+        ~Mesh();
+        GLuint program;
+        GLuint vao;
+        mat4 modelMatrix;
+        mat4 rotationMatrix;
+        mat4 translationMatrix;
+        Material material;
+        // around the vertices as last uploaded, before modelMatrix
+        vec3 boundCenter, boundLo, boundHi;
+        float boundRadius;
+        // the box around the bounding box once modelMatrix has moved it
+        void worldBox(vec3 &lo, vec3 &hi) const;
+
+    protected:
+        GLuint loadShaders(const char* vertf, const char* fragf);
+        void setupVertexAttribs(GLsizei stride);
+        void setupPackedVertexAttribs();
+        void uploadVertices(const vec2 *uv);
+
+        QOGLVER *gl;
+
+        GLuint buffers[4];
+        const char* names[3]={"position","color","normal"};
+        //        GLuint ptsBuf;
+//        GLuint colorBuf;
+//        GLuint normalBuf;
+//        GLuint indexBuf;
+
+        GLint index[4];
+        int modelMatLoc;
+        int normalMatLoc;       // modelNormal, in the shaders that light
+        // model and its normal matrix, for the program in use
+        void setModelUniforms();
+
+        int packedVertices;     // upload 16 byte packed vertices instead of 36 byte floats
+        int uploadedPacked;     // format the attribute pointers are currently set up for
+        GLsizeiptr packedSaved; // vertex buffer bytes the last upload saved by packing
+
+
+
+    public:
+        void init(QOGLVER *context);
+        void initialize(GLuint program, GLint alphaLoc,
+                                GLint aLoc, GLint sLoc, GLint dLoc,
+                                GLint sColLoc, GLint atLoc, GLint atSLoc, GLint glowLoc);
+        void render();
+        void renderTest();
+        void updateBuffers();
+        // takes effect on the next updateBuffers, not used by SimpleTexMesh
+        void setPackedVertices(int b){packedVertices=b;}
+        GLsizeiptr getPackedSaved(){return packedSaved;}
+};
+
+// slices of the instance buffer a streaming InstancedMesh cycles through
+#define INSTANCE_REGIONS 3
+
+// where one instance goes: scaled along its own axes, rotated, then moved to pos. Every
+// transform buildWall and the mortar make is one of these. 40 bytes here instead of a
+// mat4's 64, and 28 in the instance buffer (PackedInstance in mesh.cpp).
+class InstanceXform{
+    public:
+        vec3 pos;
+        glm::quat rot;
+        vec3 scale;
+
+        InstanceXform(): pos(0.0f), rot(1,0,0,0), scale(1.0f){
+        }
+        // m has to be translate*rotate*scale, without shear
+        explicit InstanceXform(const mat4 &m);
+        mat4 toMat4() const;
+};
+
+class InstancedMesh : public Mesh{
+
+    public:
+        std::vector<InstanceXform> instances;
+        std::vector<vec3> instanceVel;
+        std::vector<int> instanceOnGround;
+
+        GLuint instanceBuf;
+        GLint instancePosLoc, instanceRotLoc, instanceScaleLoc;
+
+        // lod i is drawn for instances closer than lodDist[i] to viewPos, the last lod for
+        // everything further. No distances means every instance gets lod 0.
+        std::vector<float> lodDist;
+        vec3 viewPos;
+        std::vector<uint> lodInstances;     // instances per lod in the last render()
+
+        // instances whose bounding spheres are outside the frustum of viewProj are left out
+        // of the draw, see setCulling. Set viewProj before render(), like viewPos.
+        mat4 viewProj;
+        uint culledInstances;               // in the last render()
+
+        InstancedMesh();
+
+        void initialize(GLuint program, GLint alphaLoc,
+                        GLint aLoc, GLint sLoc, GLint dLoc,
+                        GLint sColLoc, GLint atLoc, GLint atSLoc,GLint glowLoc);
+        void updateInstanceMatBuffers();
+        void clearInstances();
+        // adding many instances: beginInstances, addInstance each, commitInstances. Nothing
+        // is uploaded until the commit, then everything once. Batches nest, the outermost
+        // commit uploads. Outside a batch every addInstance uploads on its own.
+        void beginInstances(uint expected=0);
+        void commitInstances();
+        void addInstance(const InstanceXform &x);
+        void addInstance(const mat4 &transform){addInstance(InstanceXform(transform));}
+        void render();
+        // just the draw calls, for whatever program is in use with its uniforms set
+        void drawInstances();
+
+        // for instances that change every frame: uploads go round INSTANCE_REGIONS slices
+        // of the buffer instead of replacing all of it, see uploadInstances
+        void setStreaming(int s);
+        // streamed uploads, and how many of them had to wait for the gpu and for how long,
+        // since the last reportStreaming()
+        uint streamUploads, streamStalls;
+        double streamStallMs;
+        void reportStreaming();
+
+        // the instance attributes point at buffers someone else keeps on the gpu (the
+        // explosion in ExplosionSim) instead of at uploads of instances. Everything is
+        // drawn at lod 0, there are no positions on this side to pick lods from. Turning
+        // it off uploads instances again.
+        void setExternalInstances(int e);
+        int externalInstances(){return external;}
+
+        // with culling on, every render() tests the instances against viewProj and draws
+        // only what's in view, and committed batches are put in Morton order so the bricks
+        // of a wall section sit together in the buffer
+        void setCulling(int c);
+        // Instances added from now on belong to group g (a wall section, say). Culling
+        // leaves out every instance of a hidden group as well, see setGroupHidden.
+        void setInstanceGroup(uint g){currentGroup=g;}
+        void setGroupHidden(uint g, int hidden);
+        void showAllGroups(){groupHidden.clear();}
+        // box around each group's instances, each instance's box being the mesh's moved by
+        // modelMatrix and the instance. Groups without instances get an inside-out box,
+        // lo above hi, that any min/max with a real one gets rid of.
+        void groupBounds(std::vector<vec3> &lo, std::vector<vec3> &hi);
+
+        // instances culled per frame on average since the last reportCulling()
+        void reportCulling(const char *name);
+
+        int getNumInstances();
+        mat4 getInstanceMat(uint i);
+
+    private:
+        std::vector<uint> lodOrder;         // instances grouped by lod
+        std::vector<uint> instanceLod;
+        int batchDepth;
+        int external;
+
+        int culling;
+        int instancesChanged;               // since the last culled upload
+        std::vector<uint> instanceGroup;
+        uint currentGroup;
+        std::vector<char> groupHidden;
+        std::vector<float> sphereX, sphereY, sphereZ, sphereR;
+        std::vector<uint> visible, uploadedVisible;
+        uint culledSum, cullFrames;
+        // visible gets the instances in view, returns how many
+        uint cullInstances();
+        void sortInstancesMorton();
+
+        int streaming;
+        uint streamRegion;
+        size_t regionBytes;
+        GLsync regionFence[INSTANCE_REGIONS];   // set after the last draw from each slice
+        size_t instanceBase;                    // where the last upload went in the buffer
+        std::vector<char> packScratch;          // packed instances when not streaming
+        // packs instances[order[i]], or instances[i] without an order
+        void uploadInstances(const uint *order, uint n);
+
+        bool drawsLods(){return lods.size()>1 && !lodDist.empty();}
+        // of instances[order[i]] for i<n, or all of them without an order
+        void bucketInstances(const uint *order, uint n);
+        void setInstanceOffset(size_t offset);
+};
+
+class LineMesh : public Mesh{
+    public:
+        void initialize(GLuint program);
+        void updateBuffers();
+        void render();
+};
+
+class SimpleTexMesh :public Mesh{
+        GLint uvIndex;
+        std::vector<vec2> uvs;
+
+        GLuint texSlot;
+
+        GLuint loadBMP(const char * imagepath);
+
+
+
+    public:
+        void initialize(GLuint program, GLuint slot, const char *file, GLint alphaLoc,
+                        GLint aLoc, GLint sLoc, GLint dLoc,
+                        GLint sColLoc, GLint atLoc, GLint atSLoc,GLint glowLoc, GLint sampLoc, GLint magParam);
+        void updateBuffers();
+        void render();
+        void clearVertices();
+        void generateCube(float texScale);
+        void addUV(vec2 a){uvs.push_back(a);}
+        void scale(vec3 s, int bScaleTexture);
+        void scale(float s, int bScaleTexture);
+        GLuint texOb;
+};
+
+
+#endif // MESH_H
@@ -0,0 +1,131 @@
+#include "occlusion.h"
+#include <glm/gtc/type_ptr.hpp>
+
+using glm::vec3;
+using glm::mat4;
+using std::vector;
+
+// corners of a box are numbered by bits x=1, y=2, z=4 set for the hi side
+static const GLuint boxIdx[36]={0,2,1, 1,2,3,  4,5,6, 5,7,6,  0,1,4, 1,5,4,
+                                2,6,3, 3,6,7,  0,4,2, 2,4,6,  1,3,5, 3,7,5};
+
+OcclusionQueries::OcclusionQueries(){
+    gl=0;
+    program=0;
+    modelLoc=-1;
+    vao=0;
+}
+
+void OcclusionQueries::init(QOGLVER *context){
+    gl=context;
+}
+
+void OcclusionQueries::initialize(GLuint prog){
+    program=prog;
+    modelLoc=gl->glGetUniformLocation(program,"model");
+    gl->glGenVertexArrays(1,&vao);
+    gl->glBindVertexArray(vao);
+    gl->glGenBuffers(2,buffers);
+    gl->glBindBuffer(GL_ARRAY_BUFFER,buffers[0]);
+    GLint pos=gl->glGetAttribLocation(program,"position");
+    gl->glEnableVertexAttribArray(pos);
+    gl->glVertexAttribPointer(pos,3,GL_FLOAT,GL_FALSE,0,0);
+    // the same 36 indices for every box, the draws pick the box with their base vertex
+    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,buffers[1]);
+    gl->glBufferData(GL_ELEMENT_ARRAY_BUFFER,sizeof(boxIdx),boxIdx,GL_STATIC_DRAW);
+    gl->glBindVertexArray(0);
+}
+
+// boxes and their corners, grown by OCCLUSION_PAD
+void OcclusionQueries::padBoxes(uint first, uint n, const vec3 *lo, const vec3 *hi){
+    for(uint i=first;i<first+n;i++){
+        boxLo[i]=lo[i-first]-vec3(OCCLUSION_PAD);
+        boxHi[i]=hi[i-first]+vec3(OCCLUSION_PAD);
+        for(int c=0;c<8;c++)
+            corners[8*i+c]=vec3(c&1? boxHi[i].x : boxLo[i].x, c&2? boxHi[i].y : boxLo[i].y,
+                                c&4? boxHi[i].z : boxLo[i].z);
+    }
+}
+
+void OcclusionQueries::setBoxes(const vector<vec3> &lo, const vector<vec3> &hi){
+    uint n=lo.size();
+    boxLo.resize(n);
+    boxHi.resize(n);
+    corners.resize(8*n);
+    if(n)
+        padBoxes(0,n,&lo[0],&hi[0]);
+    if(queries.size()<n){
+        uint old=queries.size();
+        queries.resize(n);
+        gl->glGenQueries(n-old,&queries[old]);
+        pending.resize(n,0);
+        vis.resize(n,1);
+    }
+    gl->glBindBuffer(GL_ARRAY_BUFFER,buffers[0]);
+    gl->glBufferData(GL_ARRAY_BUFFER,corners.size()*sizeof(vec3),corners.data(),GL_DYNAMIC_DRAW);
+}
+
+void OcclusionQueries::updateBoxes(uint first, uint n, const vec3 *lo, const vec3 *hi){
+    if(first+n>boxLo.size())
+        return;
+    padBoxes(first,n,lo,hi);
+    gl->glBindBuffer(GL_ARRAY_BUFFER,buffers[0]);
+    gl->glBufferSubData(GL_ARRAY_BUFFER,8*first*sizeof(vec3),8*n*sizeof(vec3),&corners[8*first]);
+}
+
+// takes in the answers that are there, never waits for the others
+void OcclusionQueries::collect(){
+    for(uint i=0;i<pending.size();i++){
+        if(!pending[i])
+            continue;
+        GLuint ready=0;
+        gl->glGetQueryObjectuiv(queries[i],GL_QUERY_RESULT_AVAILABLE,&ready);
+        if(!ready)
+            continue;
+        GLuint passed=0;
+        gl->glGetQueryObjectuiv(queries[i],GL_QUERY_RESULT,&passed);
+        vis[i]=passed!=0;
+        pending[i]=0;
+    }
+}
+
+void OcclusionQueries::issue(const vec3 &eye){
+    collect();
+    uint n=boxLo.size();
+    if(!n)
+        return;
+
+    gl->glUseProgram(program);
+    gl->glBindVertexArray(vao);
+    mat4 identity(1.0f);
+    gl->glUniformMatrix4fv(modelLoc,1,false,glm::value_ptr(identity));
+    gl->glColorMask(GL_FALSE,GL_FALSE,GL_FALSE,GL_FALSE);
+    gl->glDepthMask(GL_FALSE);
+    // seen from inside, only the back faces are there to pass
+    gl->glDisable(GL_CULL_FACE);
+    for(uint i=0;i<n;i++){
+        if(pending[i] || glm::any(glm::greaterThan(boxLo[i],boxHi[i])))
+            continue;
+        // the near plane would cut the box open
+        vec3 m(.05f,.05f,.05f);
+        if(glm::all(glm::greaterThanEqual(eye,boxLo[i]-m)) && glm::all(glm::lessThanEqual(eye,boxHi[i]+m))){
+            vis[i]=1;
+            continue;
+        }
+        gl->glBeginQuery(GL_ANY_SAMPLES_PASSED,queries[i]);
+        gl->glDrawElementsBaseVertex(GL_TRIANGLES,36,GL_UNSIGNED_INT,0,8*i);
+        gl->glEndQuery(GL_ANY_SAMPLES_PASSED);
+        pending[i]=1;
+    }
+    gl->glEnable(GL_CULL_FACE);
+    gl->glDepthMask(GL_TRUE);
+    gl->glColorMask(GL_TRUE,GL_TRUE,GL_TRUE,GL_TRUE);
+    gl->glBindVertexArray(0);
+}
+
+uint OcclusionQueries::numHidden() const {
+    uint n=0;
+    for(uint i=0;i<boxLo.size();i++)
+        n+=!vis[i];
+    return n;
+}
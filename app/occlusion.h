@@ -0,0 +1,58 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+// occlusion.h
+// Which of a set of boxes could be seen. At the end of a frame every box is drawn into an
+// occlusion query, colour and depth writes off, against the depth the frame left behind.
+// The answers are picked up a frame or more later, only once the gpu has them, so nothing
+// ever waits. The boxes are the bounds of what they stand for, grown by OCCLUSION_PAD so
+// their faces sit clearly in front of anything the thing itself wrote to depth (a box
+// shaped mesh like the floor would otherwise tie with its own depth, and pass or fail on
+// rounding). Something hidden comes back one frame late, and that's all.
+
+#include "mesh.h"
+
+// world units the boxes are grown by, well over the depth precision at the far walls
+#define OCCLUSION_PAD .05f
+
+class OcclusionQueries{
+    public:
+        OcclusionQueries();
+
+        void init(QOGLVER *context);
+        // program takes position, projection, view and model, like grid_vert.glsl
+        void initialize(GLuint program);
+
+        // world space boxes to test from now on, grown by OCCLUSION_PAD. Answers carry
+        // over by index. Inside-out boxes (lo above hi, nothing in them) are never queried.
+        void setBoxes(const std::vector<vec3> &lo, const std::vector<vec3> &hi);
+        // moves boxes first to first+n-1 of the ones setBoxes gave, only their corners
+        // get uploaded again
+        void updateBoxes(uint first, uint n, const vec3 *lo, const vec3 *hi);
+        // queries every box that has its last answer in, against the depth buffer as it
+        // stands. A box with the eye in it is visible without asking.
+        void issue(const vec3 &eye);
+        // whether box i had any samples pass in its last answered query. Boxes that
+        // never got an answer count as visible.
+        int visible(uint i) const {return i>=vis.size() || vis[i];}
+        uint numHidden() const;
+
+    private:
+        OcclusionQueries(const OcclusionQueries&);
+        OcclusionQueries& operator=(const OcclusionQueries&);
+
+        QOGLVER *gl;
+        GLuint program;
+        GLint modelLoc;
+        GLuint vao, buffers[2];
+        std::vector<GLuint> queries;
+        std::vector<int> pending;   // issued and not answered yet
+        std::vector<int> vis;
+        std::vector<vec3> boxLo, boxHi;
+        std::vector<vec3> corners;  // 8 per box, as they are in buffers[0]
+
+        void padBoxes(uint first, uint n, const vec3 *lo, const vec3 *hi);
+        void collect();
+};
+
+#endif // OCCLUSION_H
@@ -0,0 +1,39 @@
+#version 330
+
+// one frame of the exploding bricks, the same steps as the cpu version in
+// GLWidget::brickExplosion. Drawn as one point per brick with the rasterizer off, the
+// outputs caught by transform feedback into the other state buffer (see ExplosionSim).
+// NSPINS comes in from the loader.
+
+in vec4 simPos;     // xyz, w is 1 once the brick is on the ground
+in vec4 simRot;     // unit quaternion, xyzw
+in vec3 simVel;
+
+// the turn each frame of brick i is spins[i%NSPINS]
+uniform vec4 spins[NSPINS];
+uniform float gravity;
+
+out vec4 outPos;
+out vec4 outRot;
+out vec3 outVel;
+
+// q*r, as glm does it
+vec4 quatMul(vec4 q, vec4 r){
+    return vec4(q.w*r.xyz+r.w*q.xyz+cross(q.xyz,r.xyz), q.w*r.w-dot(q.xyz,r.xyz));
+}
+
+void main() {
+    outPos=simPos;
+    outRot=simRot;
+    outVel=simVel;
+    if(simPos.w!=0)
+        return;
+
+    // move, then spin about the brick's own axes
+    outPos.xyz+=simVel;
+    outRot=quatMul(simRot,spins[gl_VertexID%NSPINS]);
+    outVel.y-=gravity;
+
+    if(outPos.y<0)
+        outPos.w=1;
+}
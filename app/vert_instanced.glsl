@@ -0,0 +1,56 @@
+#version 330
+
+
+in vec3 position;
+in vec3 color;
+in vec3 normal;
+
+// the instance's placement, packed (see PackedInstance in mesh.cpp)
+in vec3 instancePos;
+in vec4 instanceRot;    // unit quaternion, half floats
+in vec3 instanceScale;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform mat3 modelNormal;   // transpose(inverse(mat3(model))), once per draw on the cpu
+
+
+out vec3 fcolor;
+out vec3 fnorm;
+out vec3 fpos;
+
+// the rotation part, from the quaternion the usual way
+mat3 instanceRotation(){
+    vec4 q=normalize(instanceRot);
+    vec3 q2=q.xyz*2;
+    float xx=q.x*q2.x, yy=q.y*q2.y, zz=q.z*q2.z;
+    float xy=q.x*q2.y, xz=q.x*q2.z, yz=q.y*q2.z;
+    float wx=q.w*q2.x, wy=q.w*q2.y, wz=q.w*q2.z;
+    return mat3(vec3(1-yy-zz, xy+wz,   xz-wy),
+                vec3(xy-wz,   1-xx-zz, yz+wx),
+                vec3(xz+wy,   yz-wx,   1-xx-yy));
+}
+
+void main() {
+    mat3 rot=instanceRotation();
+    fcolor = color;
+
+#ifdef NORMAL_MATRIX_PER_VERTEX
+    // the whole matrix and its inverse for every vertex, only built for the comparison
+    // in GLWidget::benchmarkBrickGPU
+    mat4 instanceMat=mat4(vec4(rot[0]*instanceScale.x,0),vec4(rot[1]*instanceScale.y,0),
+                          vec4(rot[2]*instanceScale.z,0),vec4(instancePos,1));
+    gl_Position = projection * view * instanceMat *model *  vec4(position, 1);
+    fpos=vec3(view*instanceMat*model*vec4(position,1));
+    fnorm=vec3(transpose(inverse(view*instanceMat*model)) *vec4(normalize(normal),0)       );
+#else
+    vec4 vpos=view*vec4(rot*(instanceScale*vec3(model*vec4(position,1)))+instancePos,1);
+    gl_Position=projection*vpos;
+    fpos=vec3(vpos);
+    // view and rotation are rigid so normals go through them as they are, and the inverse
+    // transpose of the scale is dividing by it. Normal may come in packed to 10 bits, the
+    // fragment shader renormalizes.
+    fnorm=mat3(view)*(rot*((modelNormal*normal)/instanceScale));
+#endif
+}
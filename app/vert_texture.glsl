@@ -9,6 +9,7 @@ in vec2 uv;
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
+uniform mat3 modelNormal;   // transpose(inverse(mat3(model))), once per draw on the cpu
 
 out vec3 fcolor;
 out vec3 fnorm;
@@ -16,10 +17,11 @@ out vec3 fpos;
 out vec2 fuv;
 
 void main() {
-    gl_Position = projection * view *  model * vec4(position, 1);
+    vec4 vpos=view*model*vec4(position,1);
+    gl_Position = projection * vpos;
     fcolor = color;
 
-    fpos=vec3(view*model*vec4(position,1));
-    fnorm=vec3(transpose(inverse(view*model)) * vec4(normal,0));
+    fpos=vec3(vpos);
+    fnorm=mat3(view)*(modelNormal*normal);
     fuv=uv;
 }
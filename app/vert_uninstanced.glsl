@@ -0,0 +1,26 @@
+#version 330
+
+
+in vec3 position;
+in vec3 color;
+in vec3 normal;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform mat3 modelNormal;   // transpose(inverse(mat3(model))), once per draw on the cpu
+
+out vec3 fcolor;
+out vec3 fnorm;
+out vec3 fpos;
+
+void main() {
+    vec4 vpos=view*model*vec4(position,1);
+    gl_Position = projection * vpos;
+    fcolor = color;
+
+    fpos=vec3(vpos);
+    // view is rigid, so only model needs its inverse transpose. Normal may come in packed
+    // to 10 bits, the fragment shader renormalizes.
+    fnorm=mat3(view)*(modelNormal*normal);
+}
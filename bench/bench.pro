@@ -0,0 +1,27 @@
+#-------------------------------------------------
+#
+# Times the brick geometry steps without a window or GL context.
+#
+#-------------------------------------------------
+
+QT       -= gui
+
+TARGET = brickbench
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD/../include $$PWD/../meshdata
+DEPENDPATH += $$PWD/../meshdata
+
+SOURCES += main.cpp
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../meshdata/release/ -lmeshdata
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../meshdata/debug/ -lmeshdata
+else:unix: LIBS += -L$$OUT_PWD/../meshdata/ -lmeshdata
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../meshdata/release/libmeshdata.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../meshdata/debug/libmeshdata.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../meshdata/release/meshdata.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../meshdata/debug/meshdata.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/../meshdata/libmeshdata.a
@@ -0,0 +1,143 @@
+// brickbench
+// Times the steps that build a brick at each detail level, using the meshdata library on
+// its own: no window, no GL context. Run as "brickbench [max level] [repeats]".
+
+#include "meshdata.h"
+#include "brickpipeline.h"
+#include "meshkernels.h"
+#include <QElapsedTimer>
+#include <cstdlib>
+#include <cmath>
+#include <atomic>
+#include <new>
+
+// every heap allocation in the program comes through here, so the bench can count them
+static std::atomic<long> allocCount(0);
+
+void* operator new(size_t n){
+    allocCount++;
+    void *p=malloc(n? n : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept{
+    free(p);
+}
+
+// best of repeats, in ms
+template<class F>
+static double timeBest(int repeats, F f){
+    double best=1e30;
+    for(int r=0;r<repeats;r++){
+        QElapsedTimer t;
+        t.start();
+        f();
+        best=std::min(best,t.nsecsElapsed()/1e6);
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]){
+    int maxLevel= argc>1? atoi(argv[1]) : 6;
+    int repeats= argc>2? atoi(argv[2]) : 5;
+    vec3 color(1.0f,100/255.0f,15/255.0f);
+    float radius=.1f,rough=.5f;
+    uint seed=1;
+
+    cout<<"bulk transforms: "<<vec3KernelName()<<", best of "<<repeats<<", ms"<<endl;
+    cout<<"level\tverts\ttris\tadaptive tris\tgenerate\tround\tnormals\troughen\tflat\toptimize\tACMR"<<endl;
+    for(int lvl=1;lvl<=maxLevel;lvl++){
+        MeshData m;
+        double gen=timeBest(repeats,[&]{ m.clearVertices(); m.generateBrick(color,lvl); });
+        MeshData base=m;
+        double rnd=timeBest(repeats,[&]{ m=base; m.roundEdges(radius); })
+                -timeBest(repeats,[&]{ m=base; });
+        m=base;
+        m.roundEdges(radius);
+        double nrm=timeBest(repeats,[&]{ m.computeNormals(1); });
+        MeshData rounded=m;
+        double rgh=timeBest(repeats,[&]{ m=rounded; m.roughen(rough,lvl,seed); })
+                -timeBest(repeats,[&]{ m=rounded; });
+        MeshData rougher=m;
+        double flat=timeBest(repeats,[&]{ m=rougher; m.makeFlatShade(); })
+                -timeBest(repeats,[&]{ m=rougher; });
+        m=rougher;
+        m.computeNormals(1);
+        MeshData smooth=m;
+        double opt=timeBest(repeats,[&]{ m=smooth; m.optimize(); })-timeBest(repeats,[&]{ m=smooth; });
+        std::vector<OptimizeStats> stats;
+        m=smooth;
+        m.optimize(0,&stats);
+
+        MeshData adaptive;
+        adaptive.generateAdaptiveBrick(color,lvl,radius,rough);
+
+        cout<<lvl<<"\t"<<smooth.getNumVerts()<<"\t"<<smooth.getNumIdx()/3<<"\t"<<adaptive.getNumIdx()/3<<"\t"<<gen<<"\t"<<rnd<<"\t"
+            <<nrm<<"\t"<<rgh<<"\t"<<flat<<"\t"<<opt;
+        for(uint i=0;i<stats.size();i++)
+            cout<<"\t"<<stats[i].acmrBefore<<" -> "<<stats[i].acmrAfter;
+        cout<<endl;
+    }
+
+    // whole brick through the pipeline, from nothing and then with only later stages changed
+    cout<<endl<<"pipeline, levels "<<maxLevel<<" to 1:"<<endl;
+    BrickPipeline pipeline;
+    BrickParams p;
+    p.color=color;
+    p.subdivides=maxLevel;
+    p.radius=radius;
+    p.rough=rough;
+    p.seed=seed;
+    p.adaptive=0;
+    p.simplify=0;
+    MeshData brick;
+    // no cache file, every build goes through the stages
+    pipeline.build(brick,p,QString(),0);
+    // new seed, generate and round come from the memo
+    p.seed++;
+    pipeline.build(brick,p,QString(),0);
+    p.adaptive=1;
+    pipeline.build(brick,p,QString(),0);
+
+    // generated against simplified far lods: triangles, error, and how far away a 1 unit
+    // brick has to be for that error to be under a pixel, 1080 pixels high at 45 degrees
+    float pixelsPerUnit=1080/(2*std::tan(glm::radians(45.0f)/2));
+    p.adaptive=0;
+    for(p.simplify=0;p.simplify<2;p.simplify++){
+        cout<<endl<<(p.simplify? "simplified" : "generated")<<" lods:"<<endl;
+        pipeline.build(brick,p,QString(),0);
+        brick.scale(0.5f);
+        for(int l=0;l<brick.getNumLods();l++){
+            const MeshRange &r=brick.getLod(l);
+            cout<<"lod "<<l<<"\t"<<r.nIdx/3<<" tris\terror "<<r.error;
+            if(r.error>0)
+                cout<<"\t1 px at "<<r.error*pixelsPerUnit;
+            cout<<endl;
+        }
+    }
+
+    // what one rebuildGeometry in the app asks of meshdata: the brick with the app's
+    // defaults, then the mortar box. The first one starts from nothing, the second is a
+    // new seed once the arenas have grown to size.
+    BrickPipeline fresh;
+    MeshArena scratch;
+    MeshData mortar;
+    p.adaptive=1;
+    p.simplify=1;
+    for(int r=0;r<2;r++){
+        cout<<endl<<(r? "rebuild, new seed:" : "first rebuild:")<<endl;
+        long before=allocCount;
+        fresh.build(brick,p,QString(),0);
+        long brickAllocs=allocCount-before;
+        before=allocCount;
+        scratch.reset();
+        mortar.clearVertices();
+        mortar.generateCube(vec3(.5f),1);
+        mortar.computeNormals(1,&scratch);
+        long mortarAllocs=allocCount-before;
+        cout<<"heap allocations: brick "<<brickAllocs<<", mortar "<<mortarAllocs<<endl;
+        p.seed++;
+    }
+    return 0;
+}
@@ -1,29 +1,17 @@
 #-------------------------------------------------
 #
-# Project created by QtCreator 2016-03-26T20:37:38
+# meshdata: GL-free geometry library
+# app:      the brickExplosion program
+# bench:    command line benchmark of the brick geometry
 #
 #-------------------------------------------------
 
-QT       += opengl
-
-INCLUDEPATH += $$PWD/include
-
-
-CONFIG += console c++11
-
-SOURCES += main.cpp\
-        glwidget.cpp \
-    mainwindow.cpp \
-    mesh.cpp
-
-HEADERS  += glwidget.h \
-    mainwindow.h \
-    mesh.h
-
-RESOURCES += \
-    shaders.qrc
-
-FORMS += \
-    mainwindow.ui
+TEMPLATE = subdirs
 
+SUBDIRS += \
+    meshdata \
+    app \
+    bench
 
+app.depends = meshdata
+bench.depends = meshdata
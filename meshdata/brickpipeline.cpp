@@ -0,0 +1,177 @@
+
+#include "brickpipeline.h"
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFileInfo>
+
+static const char* stageNames[]={"generate","round","roughen","simplify","normals"};
+
+// newest first, so whatever is past BRICK_CACHE_FILES is the oldest, older versions'
+// files included
+static void pruneCache(const QString &cacheFile){
+    QDir dir=QFileInfo(cacheFile).absoluteDir();
+    QFileInfoList files=dir.entryInfoList(QStringList("*.mesh"),QDir::Files,QDir::Time);
+    for(int i=BRICK_CACHE_FILES;i<files.size();i++)
+        QFile::remove(files[i].absoluteFilePath());
+}
+
+BrickPipeline::BrickPipeline(){
+    clear();
+}
+
+void BrickPipeline::clear(){
+    for(int s=0;s<NSTAGES;s++)
+        stages[s].clear();
+    builtKey.clear();
+}
+
+// everything the output of a stage depends on: its own settings and those of all the
+// stages before it
+std::vector<uint> BrickPipeline::stageKey(int stage, int level, const BrickParams &p){
+    std::vector<uint> k;
+    k.push_back(level);
+    k.push_back(floatBits(p.color.r));
+    k.push_back(floatBits(p.color.g));
+    k.push_back(floatBits(p.color.b));
+    k.push_back(p.adaptive);
+    // the adaptive grid already depends on the radius and roughness
+    if(stage>=ROUND || p.adaptive)
+        k.push_back(floatBits(p.radius));
+    if(stage>=ROUGHEN || p.adaptive)
+        k.push_back(floatBits(p.rough));
+    if(stage>=ROUGHEN)
+        k.push_back(p.seed);
+    // simplified levels come down a chain from the full one
+    if(stage>=SIMPLIFY){
+        k.push_back(p.simplify);
+        if(p.simplify)
+            k.push_back(p.subdivides);
+    }
+    return k;
+}
+
+const BrickPipeline::Entry& BrickPipeline::runStage(int stage, int level, const BrickParams &p){
+    std::vector<uint> key=stageKey(stage,level,p);
+    std::map<int,Entry>::iterator it=stages[stage].find(level);
+    if(it!=stages[stage].end() && it->second.key==key)
+        return it->second;
+
+    // upstream first, so the timer only counts this stage. Simplified levels start from
+    // the next finer one instead of their own generated level.
+    bool simplified= stage==SIMPLIFY && p.simplify && level<p.subdivides;
+    const Entry *in= simplified? &runStage(SIMPLIFY,level+1,p)
+                   : stage>GENERATE? &runStage(stage-1,level,p) : 0;
+
+    QElapsedTimer t;
+    t.start();
+    Entry &e=stages[stage][level];
+    e.error= in? in->error : 0;
+    if(in)
+        e.mesh=in->mesh;
+    else
+        e.mesh.clearVertices();
+    MeshData &m=e.mesh;
+    switch(stage){
+    case GENERATE:
+        if(p.adaptive)
+            m.generateAdaptiveBrick(p.color,level,p.radius,p.rough,&scratch);
+        else
+            m.generateBrick(p.color,level);
+        break;
+    case ROUND:
+        m.roundEdges(p.radius);
+        //compute normals for to classify points as which side they are on
+        m.computeNormals(1,&scratch);
+        break;
+    case ROUGHEN:
+        m.roughen(p.rough,level,p.seed);
+        break;
+    case SIMPLIFY:
+        // a quarter of the triangles each level down, like one subdivide less
+        if(simplified)
+            e.error+=m.simplify(m.getNumIdx()/12,1e30f,&scratch);
+        break;
+    case NORMALS:
+        // angle weighted vertex normals of the finished (rounded, roughened, maybe simplified)
+        // shape, the vertices stay shared so optimize has something to reuse
+        m.computeNormals(1,&scratch);
+        break;
+    }
+    scratch.reset();
+    e.key=key;
+    stageMs[stage]+=t.nsecsElapsed()/1e6;
+    stageRuns[stage]++;
+    return e;
+}
+
+bool BrickPipeline::build(MeshData &brick, const BrickParams &p, const QString &cacheFile, uint cacheVersion,
+                          const std::atomic<int> *cancel){
+    std::vector<uint> key=stageKey(NORMALS,p.subdivides,p);
+    if(key==builtKey){
+        cout<<"brick unchanged, nothing to rebuild"<<endl;
+        return false;
+    }
+
+    QElapsedTimer t;
+    t.start();
+    brick.clearVertices();
+    if(!cacheFile.isEmpty() && brick.readBinary(cacheFile,cacheVersion)){
+        cout<<"brick loaded from cache in "<<t.nsecsElapsed()/1e6<<" ms"<<endl;
+        builtKey=key;
+        return true;
+    }
+
+    for(int s=0;s<NSTAGES;s++){
+        stageMs[s]=0;
+        stageRuns[s]=0;
+    }
+    // lod 0 is the full subdivides level, each one after it half the resolution, down to 1
+    // (or just the plain box at 0). Cancel is checked between levels, a level in progress
+    // finishes and stays cached
+    std::vector<const Entry*> levels;
+    for(int lvl=p.subdivides;lvl>=std::min(1,p.subdivides);lvl--){
+        if(cancel && *cancel){
+            cout<<"brick build cancelled after "<<t.nsecsElapsed()/1e6<<" ms"<<endl;
+            return false;
+        }
+        levels.push_back(&runStage(NORMALS,lvl,p));
+    }
+    // all the levels in one go, sized once
+    uint nVerts=0,nIdx=0;
+    for(uint l=0;l<levels.size();l++){
+        nVerts+=levels[l]->mesh.getNumVerts();
+        nIdx+=levels[l]->mesh.getNumIdx();
+    }
+    brick.reserve(nVerts,nIdx);
+    for(uint l=0;l<levels.size();l++)
+        brick.addLod(levels[l]->mesh,levels[l]->error);
+
+    QElapsedTimer ta;
+    ta.start();
+    // rescale to 1 unit
+    // should have made the cube function create a 1x1 instead but changing it
+    // messes up the roughness calculations
+    brick.scale(0.5f);
+    brick.optimize(&scratch);
+    scratch.reset();
+    double assembleMs=ta.nsecsElapsed()/1e6;
+
+    cout<<"brick generated in "<<t.nsecsElapsed()/1e6<<" ms:";
+    for(int s=0;s<NSTAGES;s++){
+        cout<<" "<<stageNames[s]<<" ";
+        if(stageRuns[s])
+            cout<<stageMs[s]<<" ms ("<<stageRuns[s]<<" of "<<levels.size()<<" levels),";
+        else
+            cout<<"cached,";
+    }
+    cout<<" scale+optimize "<<assembleMs<<" ms"<<endl;
+
+    if(!cacheFile.isEmpty()){
+        if(brick.writeBinary(cacheFile,cacheVersion))
+            pruneCache(cacheFile);
+        else
+            cout<<"could not write brick cache "<<cacheFile.toStdString()<<endl;
+    }
+    builtKey=key;
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef BRICKPIPELINE_H
+#define BRICKPIPELINE_H
+
+// brickpipeline.h
+// The steps that turn the brick settings into the brick mesh. Each step keeps its last
+// output for every detail level, keyed by everything that went into it, so changing one
+// setting only re-runs the steps after the one that uses it.
+
+#include <map>
+#include <atomic>
+#include <vector>
+#include <QString>
+#include <cstring>
+#include "meshdata.h"
+
+// bricks kept in the cache file's directory, the newest ones. Every radius, roughness, seed
+// and color a slider passes through writes its own file.
+#define BRICK_CACHE_FILES 16
+
+class BrickParams{
+    public:
+        vec3 color;
+        int subdivides;
+        float radius;
+        float rough;
+        uint seed;
+        int adaptive;       // generateAdaptiveBrick instead of generateBrick
+        int simplify;       // lods after the first simplified from it instead of generated
+};
+
+// the exact bits of a float setting, for the stage keys and the cache file names
+inline uint floatBits(float f){
+    uint u;
+    memcpy(&u,&f,sizeof(u));
+    return u;
+}
+
+class BrickPipeline{
+    public:
+        BrickPipeline();
+
+        // fills brick with lods from p.subdivides down to 1, unit sized and optimized.
+        // A finished brick is also kept in cacheFile, if there is one, and all but the newest
+        // BRICK_CACHE_FILES .mesh files next to it are deleted. Returns false if the last brick built
+        // was already the one for p, or if cancel got set before it was done; the stages
+        // that did finish stay cached either way.
+        bool build(MeshData &brick, const BrickParams &p, const QString &cacheFile, uint cacheVersion,
+                   const std::atomic<int> *cancel=0);
+        // forget everything, the next build starts from scratch
+        void clear();
+
+    private:
+        // in the order they run, each one's input is the output of the one before
+        enum Stage{GENERATE,ROUND,ROUGHEN,SIMPLIFY,NORMALS,NSTAGES};
+
+        class Entry{
+            public:
+                std::vector<uint> key;
+                MeshData mesh;
+                float error;    // distance from the full level's surface, see MeshRange
+        };
+        std::map<int,Entry> stages[NSTAGES];    // by level
+        std::vector<uint> builtKey;              // what the last finished build() made
+        // temporary arrays for whichever stage is running, emptied after each one
+        MeshArena scratch;
+
+        double stageMs[NSTAGES];
+        int stageRuns[NSTAGES];
+
+        std::vector<uint> stageKey(int stage, int level, const BrickParams &p);
+        const Entry& runStage(int stage, int level, const BrickParams &p);
+};
+
+#endif // BRICKPIPELINE_H
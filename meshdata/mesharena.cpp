@@ -0,0 +1,65 @@
+#include "mesharena.h"
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <new>
+
+// first block, and the least a new block gets
+#define ARENA_MIN_BLOCK (64*1024)
+
+MeshArena::MeshArena(){
+    cur=end=0;
+    usedBytes=peakBytes=0;
+    nBlocks=0;
+}
+
+MeshArena::~MeshArena(){
+    for(size_t i=0;i<blocks.size();i++)
+        free(blocks[i]);
+}
+
+void MeshArena::newBlock(size_t minBytes){
+    size_t size=ARENA_MIN_BLOCK;
+    if(!blockSizes.empty())
+        size=std::max(size,blockSizes.back()*2);
+    size=std::max(size,minBytes);
+    char *b=static_cast<char*>(malloc(size));
+    if(!b)
+        throw std::bad_alloc();
+    blocks.push_back(b);
+    blockSizes.push_back(size);
+    nBlocks++;
+    cur=b;
+    end=b+size;
+}
+
+void* MeshArena::alloc(size_t bytes, size_t align){
+    uintptr_t p=(reinterpret_cast<uintptr_t>(cur)+align-1)&~(uintptr_t)(align-1);
+    if(!cur || p+bytes>reinterpret_cast<uintptr_t>(end)){
+        newBlock(bytes+align);
+        p=(reinterpret_cast<uintptr_t>(cur)+align-1)&~(uintptr_t)(align-1);
+    }
+    usedBytes+=p+bytes-reinterpret_cast<uintptr_t>(cur);
+    peakBytes=std::max(peakBytes,usedBytes);
+    cur=reinterpret_cast<char*>(p+bytes);
+    return reinterpret_cast<void*>(p);
+}
+
+void MeshArena::reset(){
+    usedBytes=0;
+    if(blocks.empty())
+        return;
+    // everything fits in one block next time, so the steady state is a single block
+    if(blocks.size()>1){
+        size_t total=0;
+        for(size_t i=0;i<blocks.size();i++){
+            total+=blockSizes[i];
+            free(blocks[i]);
+        }
+        blocks.clear();
+        blockSizes.clear();
+        newBlock(std::max(total,peakBytes));
+    }
+    cur=blocks[0];
+    end=cur+blockSizes[0];
+}
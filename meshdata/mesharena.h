@@ -0,0 +1,84 @@
+#ifndef MESHARENA_H
+#define MESHARENA_H
+
+// mesharena.h
+// Scratch memory for building meshes. Allocating only moves a pointer forward and nothing
+// is freed on its own; reset() lets go of everything at once, keeping the memory for next
+// time. One arena lives as long as the thing that rebuilds (the brick pipeline, the
+// widget), is reset at the start of every rebuild, and after the first one a rebuild
+// takes no heap allocations for its temporary arrays at all.
+// Not thread safe: one arena per thread, parallelFor workers only write into arrays
+// allocated before they start.
+
+#include <vector>
+#include <cstddef>
+
+class MeshArena{
+    public:
+        MeshArena();
+        ~MeshArena();
+
+        // bytes, aligned to align (a power of two)
+        void* alloc(size_t bytes, size_t align);
+        // room for n T's, uninitialized. Only for types that need no destructor.
+        template<class T> T* alloc(size_t n){
+            return static_cast<T*>(alloc(n*sizeof(T),alignof(T)));
+        }
+        // n T's set to v
+        template<class T> T* alloc(size_t n, const T &v){
+            T *p=alloc<T>(n);
+            for(size_t i=0;i<n;i++)
+                p[i]=v;
+            return p;
+        }
+
+        // forget everything allocated. If that took more than one block, the next round
+        // gets a single block big enough for all of it.
+        void reset();
+
+        size_t used() const {return usedBytes;}
+        size_t highWater() const {return peakBytes;}
+        // blocks taken from the heap so far, over the arena's whole life
+        long heapBlocks() const {return nBlocks;}
+
+    private:
+        MeshArena(const MeshArena&);
+        MeshArena& operator=(const MeshArena&);
+
+        std::vector<char*> blocks;
+        std::vector<size_t> blockSizes;
+        char *cur, *end;
+        size_t usedBytes, peakBytes;
+        long nBlocks;
+
+        void newBlock(size_t minBytes);
+};
+
+// lets a std::vector grow inside an arena, for scratch arrays whose final size isn't known
+// up front. Freeing does nothing, so reserve() them to the largest size they can get.
+template<class T>
+class ArenaAllocator{
+    public:
+        typedef T value_type;
+
+        MeshArena *arena;
+
+        ArenaAllocator(MeshArena &a): arena(&a){
+        }
+        template<class U> ArenaAllocator(const ArenaAllocator<U> &o): arena(o.arena){
+        }
+
+        T* allocate(size_t n){
+            return arena->alloc<T>(n);
+        }
+        void deallocate(T*, size_t){
+        }
+
+        template<class U> bool operator==(const ArenaAllocator<U> &o) const {return arena==o.arena;}
+        template<class U> bool operator!=(const ArenaAllocator<U> &o) const {return arena!=o.arena;}
+};
+
+template<class T>
+using ArenaVector=std::vector<T,ArenaAllocator<T> >;
+
+#endif // MESHARENA_H
@@ -0,0 +1,57 @@
+#include "meshbuilder.h"
+
+MeshBuilder::MeshBuilder(MeshData &m, MeshArena *a): mesh(m){
+    arena=a;
+    ownArena=0;
+    finished=0;
+    pts.swap(m.pts);
+    colors.swap(m.colors);
+    normals.swap(m.normals);
+    idx.swap(m.idx);
+    m.lods.clear();
+    m.needsOptimize=1;
+}
+
+MeshBuilder::~MeshBuilder(){
+    finish();
+    delete ownArena;
+}
+
+MeshArena& MeshBuilder::scratchArena(){
+    if(!arena)
+        arena=ownArena=new MeshArena();
+    return *arena;
+}
+
+void MeshBuilder::reserve(uint nVerts, uint nIdx){
+    pts.reserve(pts.size()+nVerts);
+    colors.reserve(colors.size()+nVerts);
+    normals.reserve(normals.size()+nVerts);
+    idx.reserve(idx.size()+nIdx);
+}
+
+void MeshBuilder::addIdx(const uint *a, uint n, uint base){
+    size_t first=idx.size();
+    idx.resize(first+n);
+    for(uint i=0;i<n;i++)
+        idx[first+i]=a[i]+base;
+}
+
+void MeshBuilder::addMesh(const MeshData &m){
+    uint base=pts.size();
+    pts.insert(pts.end(),m.pts.begin(),m.pts.end());
+    colors.insert(colors.end(),m.colors.begin(),m.colors.end());
+    normals.insert(normals.end(),m.normals.begin(),m.normals.end());
+    addIdx(m.idx.data(),m.idx.size(),base);
+}
+
+void MeshBuilder::finish(){
+    if(finished)
+        return;
+    finished=1;
+    mesh.pts.swap(pts);
+    mesh.colors.swap(colors);
+    mesh.normals.swap(normals);
+    mesh.idx.swap(idx);
+    mesh.needsOptimize=1;
+}
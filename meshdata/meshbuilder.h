@@ -0,0 +1,68 @@
+#ifndef MESHBUILDER_H
+#define MESHBUILDER_H
+
+// meshbuilder.h
+// Fills a MeshData in bulk. The mesh's arrays move into the builder, grow once to the
+// exact size reserve() asks for, get filled, and move back out in finish(): no copies,
+// and no vector doubling its way up one push_back at a time. Temporary arrays for the
+// work in between come from a MeshArena (see mesharena.h).
+//
+//     MeshBuilder b(mesh,&arena);
+//     b.reserve(nVerts,nIdx);
+//     ... b.addVert(), b.addTri() ...
+//     b.finish();
+
+#include "meshdata.h"
+#include "mesharena.h"
+
+class MeshBuilder{
+    public:
+        // takes what's in m to add to it; m is empty until finish(). Without an arena the
+        // builder makes its own the first time scratch() is called.
+        MeshBuilder(MeshData &m, MeshArena *arena=0);
+        // finishes if finish() wasn't called
+        ~MeshBuilder();
+
+        // room for this many more vertices and indices, exactly
+        void reserve(uint nVerts, uint nIdx);
+
+        // returns the new vertex's index
+        uint addVert(const vec3 &p, const vec3 &color, const vec3 &normal=vec3(0,0,0)){
+            pts.push_back(p);
+            colors.push_back(color);
+            normals.push_back(normal);
+            return pts.size()-1;
+        }
+        void addTri(uint a, uint b, uint c){
+            idx.push_back(a);
+            idx.push_back(b);
+            idx.push_back(c);
+        }
+        // n indices, each plus base
+        void addIdx(const uint *a, uint n, uint base=0);
+        // all of m's vertices and triangles, renumbered to go after what's here
+        void addMesh(const MeshData &m);
+
+        uint numVerts() const {return pts.size();}
+        uint numIdx() const {return idx.size();}
+
+        // temporary space that lasts until the arena is reset
+        template<class T> T* scratch(size_t n){return scratchArena().alloc<T>(n);}
+        MeshArena& scratchArena();
+
+        // moves everything back into the mesh
+        void finish();
+
+    private:
+        MeshBuilder(const MeshBuilder&);
+        MeshBuilder& operator=(const MeshBuilder&);
+
+        MeshData &mesh;
+        MeshArena *arena;
+        MeshArena *ownArena;
+        std::vector<vec3> pts, colors, normals;
+        std::vector<uint> idx;
+        int finished;
+};
+
+#endif // MESHBUILDER_H
@@ -0,0 +1,760 @@
+
+#include "meshdata.h"
+#include "meshbuilder.h"
+#include "meshkernels.h"
+#include "meshoptimize.h"
+#include "meshsimplify.h"
+#include "parallelfor.h"
+#include <glm/gtx/rotate_vector.hpp>
+#include <unordered_map>
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <QFile>
+#include <QSaveFile>
+
+
+#define M_PI 3.14159265358979323846
+
+
+using glm::normalize;
+using glm::length;
+using glm::cross;
+using glm::dot;
+using std::cout;
+using std::endl;
+using std::vector;
+
+MeshData::MeshData(){
+    needsOptimize=1;
+}
+
+void MeshData::clearVertices(){
+    needsOptimize=1;
+    lods.clear();
+    pts.clear();
+    colors.clear();
+    normals.clear();
+    idx.clear();
+}
+
+void MeshData::reserve(uint nVerts, uint nIdx){
+    pts.reserve(pts.size()+nVerts);
+    colors.reserve(colors.size()+nVerts);
+    normals.reserve(normals.size()+nVerts);
+    idx.reserve(idx.size()+nIdx);
+}
+
+void MeshData::boundingBox(vec3 &lo, vec3 &hi) const {
+    lo=hi=vec3(0,0,0);
+    if(pts.empty())
+        return;
+    lo=hi=pts[0];
+    for(size_t i=1;i<pts.size();i++){
+        lo=glm::min(lo,pts[i]);
+        hi=glm::max(hi,pts[i]);
+    }
+}
+
+void MeshData::boundingSphere(vec3 &center, float &radius) const {
+    vec3 lo,hi;
+    boundingBox(lo,hi);
+    center=(lo+hi)*.5f;
+    float r2=0;
+    for(size_t i=0;i<pts.size();i++){
+        vec3 d=pts[i]-center;
+        r2=std::max(r2,dot(d,d));
+    }
+    radius=std::sqrt(r2);
+}
+
+template<class T>
+static void applyRemap(vector<T> &v, uint first, const uint *remap, uint n, MeshArena &scratch){
+    if(v.size()<first+n)
+        return;
+    T *old=scratch.alloc<T>(n);
+    std::copy(v.begin()+first,v.begin()+first+n,old);
+    for(uint i=0;i<n;i++)
+        v[first+remap[i]]=old[i];
+}
+
+// reorder the triangles for the post-transform cache, then the vertices into the order the
+// triangles use them. Only changes the order, the mesh looks the same. Each lod is done on
+// its own so the ranges stay put.
+// stats, if given, gets the cache numbers of every range that was reordered
+void MeshData::optimize(MeshArena *scratch, std::vector<OptimizeStats> *stats){
+    MeshArena local;
+    MeshArena &s= scratch? *scratch : local;
+    needsOptimize=0;
+    if(lods.empty()){
+        MeshRange all={0,(uint)idx.size(),0,(uint)pts.size(),0};
+        optimizeRange(all,s,stats);
+    }
+    for(uint i=0;i<lods.size();i++)
+        optimizeRange(lods[i],s,stats);
+}
+
+void MeshData::optimizeRange(const MeshRange &r, MeshArena &scratch, std::vector<OptimizeStats> *stats){
+    uint nTri=r.nIdx/3;
+    // flat shaded, every triangle has its own vertices and there is nothing to reuse
+    if(r.nVerts>=nTri*3)
+        return;
+    uint *ri=idx.data()+r.firstIdx;
+    for(uint i=0;i<r.nIdx;i++)
+        ri[i]-=r.firstVert;
+    // ACMR walks the whole index list, only when someone asked for it
+    float before= stats? computeACMR(ri,r.nIdx,r.nVerts,16,scratch) : 0;
+
+    optimizeVertexCache(ri,r.nIdx,r.nVerts,scratch);
+    uint *remap=scratch.alloc<uint>(r.nVerts);
+    optimizeVertexFetch(ri,r.nIdx,r.nVerts,remap);
+    applyRemap(pts,r.firstVert,remap,r.nVerts,scratch);
+    applyRemap(colors,r.firstVert,remap,r.nVerts,scratch);
+    applyRemap(normals,r.firstVert,remap,r.nVerts,scratch);
+
+    if(stats){
+        OptimizeStats st={nTri,before,computeACMR(ri,r.nIdx,r.nVerts,16,scratch)};
+        stats->push_back(st);
+    }
+    for(uint i=0;i<r.nIdx;i++)
+        ri[i]+=r.firstVert;
+}
+
+// quadric edge collapse down to targetTris triangles or maxError (see meshsimplify.h), then
+// the vertices nothing uses any more are dropped. Works on the whole mesh, lods are dropped.
+// Returns how far the surface moved, in mesh units.
+float MeshData::simplify(uint targetTris, float maxError, MeshArena *scratch){
+    MeshArena local;
+    MeshArena &s= scratch? *scratch : local;
+    lods.clear();
+    needsOptimize=1;
+    float error=simplifyMesh(pts.data(),pts.size(),idx,targetTris,maxError,s);
+
+    uint nVerts=pts.size();
+    uint *remap=s.alloc<uint>(nVerts);
+    optimizeVertexFetch(idx.data(),idx.size(),nVerts,remap);
+    uint used=0;
+    for(uint i=0;i<idx.size();i++)
+        used=std::max(used,idx[i]+1);
+    applyRemap(pts,0,remap,nVerts,s);
+    applyRemap(colors,0,remap,nVerts,s);
+    applyRemap(normals,0,remap,nVerts,s);
+    pts.resize(used);
+    if(colors.size()>used)
+        colors.resize(used);
+    if(normals.size()>used)
+        normals.resize(used);
+    return error;
+}
+
+// Binary mesh file: header, lod ranges, pts, colors, normals, idx, all raw. Saved after
+// optimize(), so loading one skips that too. version is the caller's, bump it whenever
+// the generating code changes so old files stop matching.
+#define MESH_FILE_MAGIC 0x4853454d  // "MESH"
+
+struct MeshFileHeader{
+    uint magic;
+    uint version;
+    uint nVerts;
+    uint nIdx;
+    uint nLods;
+};
+
+bool MeshData::writeBinary(const QString &path, uint version){
+    if(colors.size()!=pts.size() || normals.size()!=pts.size())
+        return false;
+    MeshFileHeader h={MESH_FILE_MAGIC,version,(uint)pts.size(),(uint)idx.size(),(uint)lods.size()};
+    QSaveFile f(path);
+    if(!f.open(QIODevice::WriteOnly))
+        return false;
+    f.write((const char*)&h,sizeof(h));
+    f.write((const char*)lods.data(),lods.size()*sizeof(MeshRange));
+    f.write((const char*)pts.data(),pts.size()*sizeof(vec3));
+    f.write((const char*)colors.data(),colors.size()*sizeof(vec3));
+    f.write((const char*)normals.data(),normals.size()*sizeof(vec3));
+    f.write((const char*)idx.data(),idx.size()*sizeof(uint));
+    return f.commit();
+}
+
+// maps the file and copies it straight into the vertex arrays. Returns false, leaving the
+// mesh alone, if the file is missing, truncated or from another version.
+bool MeshData::readBinary(const QString &path, uint version){
+    QFile f(path);
+    if(!f.open(QIODevice::ReadOnly) || f.size()<(qint64)sizeof(MeshFileHeader))
+        return false;
+    qint64 size=f.size();
+    const uchar *data=f.map(0,size);
+    if(!data)
+        return false;
+
+    MeshFileHeader h;
+    memcpy(&h,data,sizeof(h));
+    qint64 expect=sizeof(h)+(qint64)h.nLods*sizeof(MeshRange)+3*(qint64)h.nVerts*sizeof(vec3)
+                  +(qint64)h.nIdx*sizeof(uint);
+    if(h.magic!=MESH_FILE_MAGIC || h.version!=version || size!=expect){
+        f.unmap((uchar*)data);
+        return false;
+    }
+
+    // everything in the file is 4 byte aligned, so the arrays can be read in place
+    const MeshRange *l=(const MeshRange*)(data+sizeof(h));
+    const vec3 *v=(const vec3*)(l+h.nLods);
+    const uint *ix=(const uint*)(v+3*h.nVerts);
+    lods.assign(l,l+h.nLods);
+    pts.assign(v,v+h.nVerts);
+    colors.assign(v+h.nVerts,v+2*h.nVerts);
+    normals.assign(v+2*h.nVerts,v+3*h.nVerts);
+    idx.assign(ix,ix+h.nIdx);
+    f.unmap((uchar*)data);
+    needsOptimize=0;
+    return true;
+}
+
+// appends m as the next level of detail, coarser than the ones already added
+void MeshData::addLod(const MeshData &m, float error){
+    MeshRange r={(uint)idx.size(),(uint)m.idx.size(),(uint)pts.size(),(uint)m.pts.size(),error};
+    pts.insert(pts.end(),m.pts.begin(),m.pts.end());
+    colors.insert(colors.end(),m.colors.begin(),m.colors.end());
+    normals.insert(normals.end(),m.normals.begin(),m.normals.end());
+    idx.reserve(idx.size()+m.idx.size());
+    for(uint i=0;i<m.idx.size();i++)
+        idx.push_back(m.idx[i]+r.firstVert);
+    lods.push_back(r);
+    needsOptimize=1;
+}
+
+void MeshData::swapVertices(MeshData &m){
+    pts.swap(m.pts);
+    colors.swap(m.colors);
+    normals.swap(m.normals);
+    idx.swap(m.idx);
+    lods.swap(m.lods);
+    std::swap(needsOptimize,m.needsOptimize);
+}
+
+// edges are kept in a hash map keyed on the sorted vertex pair, so finding the midpoint
+// of a triangle edge is constant time instead of a scan through every edge.
+typedef std::unordered_map<uint64_t,uint> EdgeMap;
+
+static inline uint64_t edgeKey(uint a, uint b){
+    return a<b ? ((uint64_t)a<<32)|b : ((uint64_t)b<<32)|a;
+}
+
+// returns the midpoint vertex of edge a-b, adding it the first time the edge is seen
+static uint edgeMid(EdgeMap &edges, uint a, uint b,
+                    vector<vec3> &pts, vector<vec3> &colors, vector<vec3> &normals){
+    std::pair<EdgeMap::iterator,bool> e=edges.insert(std::make_pair(edgeKey(a,b),(uint)pts.size()));
+    if(e.second){
+        pts.push_back((pts[a]+pts[b])*0.5f);
+        normals.push_back(vec3(0,0,0));
+        colors.push_back(colors[a]);
+    }
+    return e.first->second;
+}
+
+// split every triangle into four, nSubs times. Each level is linear in the number of
+// triangles.
+void MeshData::subdivide(int nSubs){
+    needsOptimize=1;
+    for(int n=0;n<nSubs;n++){
+        uint nTri=idx.size()/3;
+        // a closed mesh has 3/2 edges per triangle, one new vertex per edge
+        uint nEdges=nTri*3/2+1;
+        EdgeMap edges;
+        edges.reserve(nEdges);
+        pts.reserve(pts.size()+nEdges);
+        colors.reserve(colors.size()+nEdges);
+        normals.reserve(normals.size()+nEdges);
+
+        vector<uint> newIdx;
+        newIdx.reserve(idx.size()*4);
+        for(uint i=0;i<nTri;i++){
+            uint v0=idx[i*3], v1=idx[i*3+1], v2=idx[i*3+2];
+            uint m0=edgeMid(edges,v0,v1,pts,colors,normals);
+            uint m1=edgeMid(edges,v1,v2,pts,colors,normals);
+            uint m2=edgeMid(edges,v2,v0,pts,colors,normals);
+
+            uint tris[]={m0,m1,m2, v0,m0,m2, v1,m1,m0, v2,m2,m1};
+            newIdx.insert(newIdx.end(),&tris[0],&tris[12]);
+        }
+        idx.swap(newIdx);
+    }
+}
+// generate 2x2x2 cube with multiple sections in the x direction (ends are still just 2 triangles each)
+void MeshData::generateCube(const vec3 &color, uint xSections){
+    needsOptimize=1;
+    vec3 v(1,1,1);
+    vec3 n(0,0,0);
+    int neg=0;
+    uint end1[]={3,2,0,0,2,1};
+    uint end2[]={3,0,2,2,0,1};
+    uint middle[]={0,1,4,4,1,5, 1,2,5,5,2,6, 2,3,6,6,3,7, 3,0,7,7,0,4};
+
+    clearVertices();
+    int num=4+xSections*4;
+    reserve(num,12+24*xSections);
+    idx.insert(idx.end(), &end1[0], &end1[6]);
+    for(int i=0;i<num/4;i++){
+
+        for(int k=0;k<4;k++){
+            pts.push_back(v);
+            normals.push_back(n);
+            colors.push_back(color);
+            neg? v.y=-v.y : v.z=-v.z;
+            neg=!neg;
+        }
+        v.x-=2.0f/xSections;
+
+        if(i<num/4 - 1){
+            idx.insert(idx.end(), &middle[0], &middle[24]);
+            for(int k=0;k<24;k++)
+                middle[k]+=4;
+            for(int k=0;k<6;k++)
+                end2[k]+=4;
+        }
+    }
+    idx.insert(idx.end(), &end2[0], &end2[6]);
+}
+
+// numbering of the vertices on the surface of a box lattice with nx*ny*nz cells, spanning
+// x from 1 to -1 and y,z from -1 to 1 like generateCube.  Corners come first, then the
+// vertices along the 12 box edges, then the inside of the 6 faces, so a seam vertex gets
+// the same number from every face that touches it.
+class BoxLattice{
+    public:
+        int nx,ny,nz;
+        BoxLattice(int x, int y, int z): nx(x), ny(y), nz(z){
+        }
+
+        uint numVerts() const {
+            return 8 + 4*(nx-1 + ny-1 + nz-1)
+                    + 2*((ny-1)*(nz-1) + (nx-1)*(nz-1) + (nx-1)*(ny-1));
+        }
+
+        vec3 pos(int i, int j, int k) const {
+            return vec3(1-2.0f*i/nx, -1+2.0f*j/ny, -1+2.0f*k/nz);
+        }
+
+        uint id(int i, int j, int k) const {
+            int ex=(i==0||i==nx), ey=(j==0||j==ny), ez=(k==0||k==nz);
+            int bx=(i==nx), by=(j==ny), bz=(k==nz);
+            if(ex && ey && ez)
+                return (bx<<2)|(by<<1)|bz;
+            uint n=8;
+            if(ey && ez)
+                return n + ((by<<1)|bz)*(nx-1) + (i-1);
+            n+=4*(nx-1);
+            if(ex && ez)
+                return n + ((bx<<1)|bz)*(ny-1) + (j-1);
+            n+=4*(ny-1);
+            if(ex && ey)
+                return n + ((bx<<1)|by)*(nz-1) + (k-1);
+            n+=4*(nz-1);
+            if(ex)
+                return n + bx*(ny-1)*(nz-1) + (j-1)*(nz-1) + (k-1);
+            n+=2*(ny-1)*(nz-1);
+            if(ey)
+                return n + by*(nx-1)*(nz-1) + (i-1)*(nz-1) + (k-1);
+            n+=2*(nx-1)*(nz-1);
+            return n + bz*(nx-1)*(ny-1) + (i-1)*(ny-1) + (j-1);
+        }
+};
+
+// one face of the lattice: a grid of nu*nv cells starting at lattice point o, stepping
+// du along u and dv along v.  Each cell is split along the p10-p01 diagonal, which is
+// how generateCube splits its quads, and subdivide keeps that diagonal direction.
+struct BoxFace{
+    int o[3];
+    int du[3];
+    int dv[3];
+    int nu,nv;
+};
+
+// generate the brick directly at its final resolution: the same surface generateCube(color,2)
+// followed by subdivide(nSubs) gives, but as a regular grid on each face, in one pass and
+// without the intermediate levels.  The faces are filled in on separate threads.
+void MeshData::generateBrick(const vec3 &color, int nSubs){
+    needsOptimize=1;
+    int n=1<<nSubs;
+    BoxLattice b(2*n,n,n);
+    BoxFace faces[6]={
+        {{0,0,n},      {0,0,-1}, {0,1,0},  n,  n},   // +x end
+        {{2*n,0,n},    {0,1,0},  {0,0,-1}, n,  n},   // -x end
+        {{0,n,n},      {0,0,-1}, {1,0,0},  n,  2*n}, // top
+        {{0,n,0},      {0,-1,0}, {1,0,0},  n,  2*n}, // back
+        {{0,0,0},      {0,0,1},  {1,0,0},  n,  2*n}, // bottom
+        {{0,0,n},      {0,1,0},  {1,0,0},  n,  2*n}  // front
+    };
+    uint triStart[7]={0};
+    for(int f=0;f<6;f++)
+        triStart[f+1]=triStart[f]+2*faces[f].nu*faces[f].nv;
+
+    clearVertices();
+    uint nVerts=b.numVerts();
+    pts.resize(nVerts);
+    colors.assign(nVerts,color);
+    normals.assign(nVerts,vec3(0,0,0));
+    idx.resize(triStart[6]*3);
+
+    // vertices on the box edges are shared by two faces, so set them here, once
+    for(int i=0;i<=b.nx;i++)
+        for(int j=0;j<=b.ny;j+=b.ny)
+            for(int k=0;k<=b.nz;k+=b.nz)
+                pts[b.id(i,j,k)]=b.pos(i,j,k);
+    for(int j=1;j<b.ny;j++)
+        for(int i=0;i<=b.nx;i+=b.nx)
+            for(int k=0;k<=b.nz;k+=b.nz)
+                pts[b.id(i,j,k)]=b.pos(i,j,k);
+    for(int k=1;k<b.nz;k++)
+        for(int i=0;i<=b.nx;i+=b.nx)
+            for(int j=0;j<=b.ny;j+=b.ny)
+                pts[b.id(i,j,k)]=b.pos(i,j,k);
+
+    parallelFor(6, nSubs>=4? 1 : 6, [&](uint f0, uint f1){
+        for(uint f=f0;f<f1;f++){
+            const BoxFace &fc=faces[f];
+            uint *out=&idx[triStart[f]*3];
+            for(int v=0;v<=fc.nv;v++){
+                for(int u=0;u<=fc.nu;u++){
+                    int i=fc.o[0]+u*fc.du[0]+v*fc.dv[0];
+                    int j=fc.o[1]+u*fc.du[1]+v*fc.dv[1];
+                    int k=fc.o[2]+u*fc.du[2]+v*fc.dv[2];
+                    if(u>0 && u<fc.nu && v>0 && v<fc.nv)
+                        pts[b.id(i,j,k)]=b.pos(i,j,k);
+                    if(u==fc.nu || v==fc.nv)
+                        continue;
+
+                    uint p00=b.id(i,j,k);
+                    uint p10=b.id(i+fc.du[0],j+fc.du[1],k+fc.du[2]);
+                    uint p01=b.id(i+fc.dv[0],j+fc.dv[1],k+fc.dv[2]);
+                    uint p11=b.id(i+fc.du[0]+fc.dv[0],j+fc.du[1]+fc.dv[1],k+fc.du[2]+fc.dv[2]);
+                    *out++=p00; *out++=p10; *out++=p01;
+                    *out++=p01; *out++=p10; *out++=p11;
+                }
+            }
+        }
+    });
+}
+
+// Lattice lines a graded face keeps along one axis of N cells: every line within band
+// cells of either end, where roundEdges bends the surface, and every step'th line between.
+// step divides N, so the kept set reads the same from either end.
+static void gradedLines(int N, int band, int step, vector<int> &lines){
+    lines.clear();
+    for(int t=0;t<=N;t++)
+        if(t<=band || t>=N-band || t%step==0)
+            lines.push_back(t);
+}
+
+// adaptive version of generateBrick: faces whose roughen displacement is under half a
+// fine cell (the top and bottom, or all of them with little roughness) keep the full
+// resolution only in the band roundEdges curves and a coarse grid inside it. The rest stay
+// full. Where a coarse face meets a full one its border cells are fanned to the full
+// face's edge vertices, so there are no cracks or T-junctions.
+#define ADAPT_TOL 0.5f
+
+void MeshData::generateAdaptiveBrick(const vec3 &color, int nSubs, float radius, float rough,
+                                     MeshArena *scratch){
+    MeshArena local;
+    MeshArena &s= scratch? *scratch : local;
+    needsOptimize=1;
+    int n=1<<nSubs;
+    BoxLattice b(2*n,n,n);
+    int N[3]={b.nx,b.ny,b.nz};
+    BoxFace faces[6]={
+        {{0,0,n},      {0,0,-1}, {0,1,0},  n,  n},   // +x end
+        {{2*n,0,n},    {0,1,0},  {0,0,-1}, n,  n},   // -x end
+        {{0,n,n},      {0,0,-1}, {1,0,0},  n,  2*n}, // top
+        {{0,n,0},      {0,-1,0}, {1,0,0},  n,  2*n}, // back
+        {{0,0,0},      {0,0,1},  {1,0,0},  n,  2*n}, // bottom
+        {{0,0,n},      {0,1,0},  {1,0,0},  n,  2*n}  // front
+    };
+    // lattice i runs along -x, so the amplitude per face normal axis is in x,y,z order
+    vec3 amp=roughenAmplitude(rough,nSubs);
+
+    // per face: which axes u and v run along, the normal axis and end, and whether it
+    // needs every lattice line
+    int uAx[6],vAx[6],nAx[6],nEnd[6],full[6];
+    int faceAt[3][2];
+    for(int f=0;f<6;f++){
+        const BoxFace &fc=faces[f];
+        for(int a=0;a<3;a++){
+            if(fc.du[a]) uAx[f]=a;
+            if(fc.dv[a]) vAx[f]=a;
+        }
+        nAx[f]=3-uAx[f]-vAx[f];
+        nEnd[f]=fc.o[nAx[f]]? 1 : 0;
+        faceAt[nAx[f]][nEnd[f]]=f;
+        float cell=std::max(2.0f/N[uAx[f]],2.0f/N[vAx[f]]);
+        full[f]= amp[nAx[f]]>=ADAPT_TOL*cell;
+    }
+
+    vector<int> fullLines[3],coarseLines[3];
+    for(int a=0;a<3;a++){
+        int band=std::min(N[a]/2,(int)std::ceil(radius*N[a]/2));
+        gradedLines(N[a],N[a],1,fullLines[a]);
+        // inside the band the grid is a quarter of the axis' length
+        gradedLines(N[a],band,std::max(1,N[a]/4),coarseLines[a]);
+    }
+
+    clearVertices();
+    // a fanned cell never has more triangles than the full cells it covers, so the full
+    // grid's count is as big as latIdx gets
+    uint maxIdx=0;
+    for(int f=0;f<6;f++)
+        maxIdx+=6*faces[f].nu*faces[f].nv;
+    ArenaVector<uint> latIdx(s);
+    latIdx.reserve(maxIdx);
+    ArenaVector<uint> poly(s);
+    poly.reserve(4+2*(b.nx+b.ny+b.nz));
+    uint nLat=b.numVerts();
+    vec3 *latPts=s.alloc<vec3>(nLat);
+    for(int f=0;f<6;f++){
+        const BoxFace &fc=faces[f];
+        const vector<int> &lu= full[f]? fullLines[uAx[f]] : coarseLines[uAx[f]];
+        const vector<int> &lv= full[f]? fullLines[vAx[f]] : coarseLines[vAx[f]];
+        // the face across each border: v=0, u=nu, v=nv, u=0. If it's full, the border
+        // cells here pick up its extra edge vertices.
+        int extra[4]={0,0,0,0};
+        if(!full[f]){
+            extra[0]=full[faceAt[vAx[f]][fc.o[vAx[f]]? 1 : 0]];
+            extra[1]=full[faceAt[uAx[f]][fc.o[uAx[f]]+fc.nu*fc.du[uAx[f]]? 1 : 0]];
+            extra[2]=full[faceAt[vAx[f]][fc.o[vAx[f]]+fc.nv*fc.dv[vAx[f]]? 1 : 0]];
+            extra[3]=full[faceAt[uAx[f]][fc.o[uAx[f]]? 1 : 0]];
+        }
+        auto lat=[&](int u, int v){
+            int i=fc.o[0]+u*fc.du[0]+v*fc.dv[0];
+            int j=fc.o[1]+u*fc.du[1]+v*fc.dv[1];
+            int k=fc.o[2]+u*fc.du[2]+v*fc.dv[2];
+            uint id=b.id(i,j,k);
+            latPts[id]=b.pos(i,j,k);
+            return id;
+        };
+
+        for(uint bv=0;bv+1<lv.size();bv++){
+            for(uint au=0;au+1<lu.size();au++){
+                int u0=lu[au],u1=lu[au+1],v0=lv[bv],v1=lv[bv+1];
+                // sides with extra vertices: bottom, right, top, left
+                int side[4]={extra[0] && v0==0 && u1-u0>1, extra[1] && u1==fc.nu && v1-v0>1,
+                             extra[2] && v1==fc.nv && u1-u0>1, extra[3] && u0==0 && v1-v0>1};
+                uint p00=lat(u0,v0),p10=lat(u1,v0),p01=lat(u0,v1),p11=lat(u1,v1);
+                if(!side[0] && !side[1] && !side[2] && !side[3]){
+                    uint t[6]={p00,p10,p01, p01,p10,p11};
+                    latIdx.insert(latIdx.end(),t,t+6);
+                    continue;
+                }
+                // walk the cell's outline the same way round as the two triangles above,
+                // starting from the corner whose two sides have no extras, and fan from it
+                int c=0;
+                while(side[c] || side[(c+3)%4])
+                    c++;
+                poly.clear();
+                for(int s=0;s<4;s++){
+                    int e=(c+s)%4;
+                    int cu[4]={u0,u1,u1,u0},cv[4]={v0,v0,v1,v1};
+                    poly.push_back(lat(cu[e],cv[e]));
+                    if(!side[e])
+                        continue;
+                    if(e==0) for(int u=u0+1;u<u1;u++) poly.push_back(lat(u,v0));
+                    if(e==1) for(int v=v0+1;v<v1;v++) poly.push_back(lat(u1,v));
+                    if(e==2) for(int u=u1-1;u>u0;u--) poly.push_back(lat(u,v1));
+                    if(e==3) for(int v=v1-1;v>v0;v--) poly.push_back(lat(u0,v));
+                }
+                for(uint k=1;k+1<poly.size();k++){
+                    uint t[3]={poly[0],poly[k],poly[k+1]};
+                    latIdx.insert(latIdx.end(),t,t+3);
+                }
+            }
+        }
+    }
+
+    // only the lattice points some triangle uses become vertices, in the order first used
+    uint *remap=s.alloc<uint>(nLat,~0u);
+    uint nVerts=0;
+    idx.resize(latIdx.size());
+    for(uint i=0;i<latIdx.size();i++){
+        uint &r=remap[latIdx[i]];
+        if(r==~0u)
+            r=nVerts++;
+        idx[i]=r;
+    }
+    pts.resize(nVerts);
+    for(uint l=0;l<nLat;l++)
+        if(remap[l]!=~0u)
+            pts[remap[l]]=latPts[l];
+    colors.assign(pts.size(),color);
+    normals.assign(pts.size(),vec3(0,0,0));
+}
+
+//generate ring lying flat with
+//inRadius, outRadius in x-z direction, 2 units in y direction
+void MeshData::generateRing(const vec3 &color, uint sections,
+                        float inRad, float outRad){
+    needsOptimize=1;
+
+    float da=2*M_PI/sections;
+    uint x[]={0,1,8,8,1,9, 2,10,3,3,10,11, 4,12,5,5,12,13, 6,7,14,14,7,15};
+    uint first=pts.size();
+    reserve(sections*8,sections*24);
+
+    for(uint i=0;i<sections;i++){
+        vec3 p0=glm::rotateY(vec3(outRad,.5f,0),da*i);
+        vec3 p1(p0.x,-.5f,p0.z);
+        vec3 p2=glm::rotateY(vec3(inRad,.5f,0),da*i);
+        vec3 p3(p2.x,-.5f,p2.z);
+        pts.push_back(p0);
+        pts.push_back(p1);
+        pts.push_back(p2);
+        pts.push_back(p3);
+
+        pts.push_back(p0);
+        pts.push_back(p2);
+
+        pts.push_back(p1);
+        pts.push_back(p3);
+
+        normals.push_back(p0);
+        normals.push_back(p1);
+        normals.push_back(-p2);
+        normals.push_back(-p3);
+
+        normals.push_back(vec3(0,1,0));
+        normals.push_back(vec3(0,1,0));
+        normals.push_back(vec3(0,-1,0));
+        normals.push_back(vec3(0,-1,0));
+
+        for(int j=0;j<24;j++)
+            idx.push_back((x[j]+i*8) % (sections*8));
+
+    }
+
+    colors.resize(pts.size(),color);
+    for(uint i=first;i<pts.size();i++)
+        normals[i]=normalize(normals[i]);
+}
+
+void MeshData::scale(vec3 s){
+    scaleVec3(pts.data(),pts.size(),s);
+    float m=std::max(std::fabs(s.x),std::max(std::fabs(s.y),std::fabs(s.z)));
+    for(uint i=0;i<lods.size();i++)
+        lods[i].error*=m;
+}
+void MeshData::scale(float s){
+    scale(vec3(s));
+}
+void MeshData::translate(const vec3 &t){
+    translateVec3(pts.data(),pts.size(),t);
+}
+void MeshData::transform(mat4 t){
+    transformVec3(pts.data(),normals.size()==pts.size()? normals.data() : 0,pts.size(),t);
+}
+void MeshData::normalizePts(float len){
+    normalizeVec3(pts.data(),pts.size(),len);
+}
+
+// bumps up the faces of a brick, see roughenVerts. Same seed, same brick.
+void MeshData::roughen(float factor, int subdivides, uint seed){
+    parallelFor(pts.size(),8192,[&](uint v0,uint v1){
+        roughenVerts(pts.data(),colors.data(),normals.data(),v0,v1,factor,subdivides,seed);
+    });
+}
+
+void MeshData::roundEdges(float radius){
+    parallelFor(pts.size(),8192,[&](uint v0,uint v1){
+        roundBoxVec3(pts.data()+v0,v1-v0,radius);
+    });
+}
+// vertex normals are the sum of the normals of the triangles around each vertex, weighted
+// by the angle of the triangle at that vertex if fine is set, added to whatever is already
+// in normals[] and normalized.
+// The face normals and corner angles are computed per triangle first, then each vertex
+// gathers its own sum through a vertex-to-corner table (CSR), so both passes can be split
+// across threads without two threads writing the same normal.
+void MeshData::computeNormals(int fine, MeshArena *scratch){
+    MeshArena local;
+    MeshArena &s= scratch? *scratch : local;
+    // should have the right number of normals already in vector<vec3> normals
+    uint nTri=idx.size()/3;
+    uint nVerts=normals.size();
+
+    vec3 *faceN=s.alloc<vec3>(nTri);
+    float *cornerW= fine? s.alloc<float>(nTri*3) : 0;
+    parallelFor(nTri, 8192, [&](uint t0, uint t1){
+        triangleNormals(&pts[0],&idx[0],t0,t1,faceN,cornerW);
+    });
+
+    // corners of each vertex: adj[adjStart[v] .. adjStart[v+1]), in triangle order so the
+    // sums add up in the same order as adding the triangles one after the other
+    uint *adjStart=s.alloc<uint>(nVerts+1,0);
+    uint *adj=s.alloc<uint>(nTri*3);
+    for(uint c=0;c<nTri*3;c++)
+        adjStart[idx[c]+1]++;
+    for(uint v=0;v<nVerts;v++)
+        adjStart[v+1]+=adjStart[v];
+    uint *fill=s.alloc<uint>(nVerts);
+    std::copy(adjStart,adjStart+nVerts,fill);
+    for(uint c=0;c<nTri*3;c++)
+        adj[fill[idx[c]]++]=c;
+
+    parallelFor(nVerts, 8192, [&](uint v0, uint v1){
+        for(uint v=v0;v<v1;v++){
+            vec3 n=normals[v];
+            for(uint a=adjStart[v];a<adjStart[v+1];a++){
+                uint c=adj[a];
+                n+=fine? faceN[c/3]*cornerW[c] : faceN[c/3];
+            }
+            normals[v]=normalize(n);
+        }
+    });
+}
+
+void MeshData::reverseNormals(){
+    for(uint i=0;i<normals.size();i++){
+        normals[i]=-normals[i];
+    }
+}
+
+//duplicate vertices for each triangle. The split mesh is built next to this one at its
+//exact size and swapped in, nothing is copied back.
+void MeshData::makeFlatShade(){
+    MeshData flat;
+    MeshBuilder b(flat);
+    uint nTri=idx.size()/3;
+    b.reserve(nTri*3,nTri*3);
+    for(uint i=0;i<nTri;i++){
+        uint ind0=idx[3*i];
+        uint ind1=idx[3*i+1];
+        uint ind2=idx[3*i+2];
+        vec3 p0= pts[ind0];
+        vec3 p1= pts[ind1];
+        vec3 p2= pts[ind2];
+
+        vec3 n=normalize(cross(p0-p1,p0-p2));
+
+        uint k=b.addVert(p0,colors[ind0],n);
+        b.addVert(p1,colors[ind1],n);
+        b.addVert(p2,colors[ind2],n);
+        b.addTri(k,k+1,k+2);
+    }
+    b.finish();
+    swapVertices(flat);
+    lods.clear();
+    needsOptimize=1;
+}
+void MeshData::copyVertices(vector<glm::vec3> &ptsIn, vector<glm::vec3> &colorsIn,
+                  vector<glm::vec3> &normalsIn, vector<uint> &idxIn){
+    pts.insert(pts.end(),ptsIn.begin(),ptsIn.end());
+    colors.insert(colors.end(),colorsIn.begin(),colorsIn.end());
+    normals.insert(normals.end(),normalsIn.begin(),normalsIn.end());
+    idx.insert(idx.end(),idxIn.begin(),idxIn.end());
+    needsOptimize=1;
+}
+void MeshData::copyVertices(vector<vec3> &ptsIn,vector<vec3> &colorsIn){
+    pts.insert(pts.end(),ptsIn.begin(),ptsIn.end());
+    colors.insert(colors.end(),colorsIn.begin(),colorsIn.end());
+}
+void MeshData::copyVertices(vec3 ptsIn[],vec3 colorsIn[], int count){
+    pts.insert(pts.end(), &ptsIn[0], &ptsIn[count]);
+    colors.insert(colors.end(), &colorsIn[0], &colorsIn[count]);
+}
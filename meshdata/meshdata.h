@@ -0,0 +1,116 @@
+#ifndef MESHDATA_H
+#define MESHDATA_H
+
+// meshdata.h
+// The geometry half of a mesh: vertices, indices and everything that builds or changes
+// them. Nothing in here needs a GL context, so it can run on any thread and outside the
+// app (see bench/). Mesh in the app adds the buffers, shader and drawing on top.
+// The steps that need temporary arrays take a MeshArena for them (see mesharena.h);
+// without one they make their own for the call.
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <QString>
+#include <vector>
+#include <iostream>
+#include "mesharena.h"
+
+using glm::mat4;
+using glm::vec2;
+using glm::vec3;
+using glm::vec4;
+using std::vector;
+
+using std::cout;
+using std::endl;
+
+// a run of triangles and the vertices they use, drawn on its own. Used to keep several
+// levels of detail back to back in the same buffers.
+class MeshRange{
+    public:
+        uint firstIdx,nIdx;
+        uint firstVert,nVerts;
+        float error;        // how far this level is from the full mesh, in mesh units
+};
+
+// post transform cache misses per triangle of one range, before and after optimize()
+class OptimizeStats{
+    public:
+        uint nTris;
+        float acmrBefore,acmrAfter;
+};
+
+class MeshData
+{
+    public:
+        MeshData();
+
+    protected:
+        std::vector<vec3> pts;
+        std::vector<vec3> colors;
+        std::vector<vec3> normals;
+        std::vector<uint> idx;
+
+        int needsOptimize;      // triangles changed since the last optimize()
+
+        // levels of detail, finest first. Empty means the whole mesh is one level.
+        std::vector<MeshRange> lods;
+
+        void optimizeRange(const MeshRange &r, MeshArena &scratch, std::vector<OptimizeStats> *stats);
+
+        friend class MeshBuilder;
+
+    public:
+        vec3 ptAt(uint i) const { return pts[i];}
+        vec3 normAt(uint i) const {return normals[i];}
+        uint getNumVerts() const {return pts.size();}
+        uint getNumIdx() const {return idx.size();}
+        // box around every vertex, all zeros without any
+        void boundingBox(vec3 &lo, vec3 &hi) const;
+        // a sphere around every vertex: the middle of their box, out to the furthest one
+        void boundingSphere(vec3 &center, float &radius) const;
+
+        void addPt(vec3 a){pts.push_back(a);}
+        void addColor(vec3 a){colors.push_back(a);}
+        void addNorm(vec3 a){normals.push_back(a);}
+        void addIdx(uint* a,int n){for(int i=0;i<n;i++)idx.push_back(a[i]); needsOptimize=1;}
+
+        void clearVertices();
+        // room for this many more vertices and indices, so adding them doesn't reallocate
+        void reserve(uint nVerts, uint nIdx);
+        // error is how far m is from the first lod's surface, see MeshRange
+        void addLod(const MeshData &m, float error=0);
+        // trades vertices, indices and lods with m, no copying
+        void swapVertices(MeshData &m);
+        bool writeBinary(const QString &path, uint version);
+        bool readBinary(const QString &path, uint version);
+        int getNumLods(){return lods.size();}
+        const MeshRange& getLod(int i){return lods[i];}
+        void optimize(MeshArena *scratch=0, std::vector<OptimizeStats> *stats=0);
+        float simplify(uint targetTris, float maxError, MeshArena *scratch=0);
+        void subdivide(int nSubs);
+        void makeFlatShade();
+        void computeNormals(int fine, MeshArena *scratch=0);
+        void reverseNormals();
+        void roundEdges(float radius);
+        void roughen(float factor, int subdivides, uint seed);
+        void generateCube(const vec3 &color, uint xSections);
+        void generateBrick(const vec3 &color, int nSubs);
+        // same surface with fewer triangles where roundEdges(radius) and roughen(rough)
+        // leave it flat, see meshdata.cpp
+        void generateAdaptiveBrick(const vec3 &color, int nSubs, float radius, float rough,
+                                   MeshArena *scratch=0);
+        void generateRing(const vec3 &color, uint sections, float inRad, float outRad);
+        void scale(vec3 s);
+        void scale(float s);
+        void translate(const glm::vec3 &t);
+        void transform(mat4 t);
+        void copyVertices(vector<vec3> &pts,vector<vec3> &colors,
+                          vector<vec3> &normals, vector<uint> &idx);
+        void copyVertices(vector<vec3> &pts,vector<vec3> &colors);
+        void copyVertices(vec3 ptsIn[],vec3 colorsIn[], int count);
+        //make round
+        void normalizePts(float len);
+};
+
+#endif // MESHDATA_H
@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# Geometry for the bricks and the rest of the meshes, no GL in here. Built as a
+# static library for the app and the command line benchmark.
+#
+#-------------------------------------------------
+
+QT       -= gui
+
+TARGET = meshdata
+TEMPLATE = lib
+CONFIG += staticlib c++11
+
+INCLUDEPATH += $$PWD/../include
+
+SOURCES += meshdata.cpp \
+    mesharena.cpp \
+    meshbuilder.cpp \
+    meshkernels.cpp \
+    meshoptimize.cpp \
+    meshsimplify.cpp \
+    brickpipeline.cpp
+
+HEADERS += meshdata.h \
+    mesharena.h \
+    meshbuilder.h \
+    parallelfor.h \
+    meshkernels.h \
+    meshoptimize.h \
+    meshsimplify.h \
+    brickpipeline.h
@@ -0,0 +1,717 @@
+
+#include "meshkernels.h"
+#include <cmath>
+#include <algorithm>
+
+#ifdef MESH_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX versions are compiled in with a target attribute and only used if the cpu has it
+#if defined(MESH_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MESH_AVX 1
+#include <immintrin.h>
+#endif
+
+using glm::vec3;
+using glm::normalize;
+using glm::cross;
+using glm::dot;
+
+#define PI_F 3.14159265358979f
+
+// Abramowitz & Stegun 4.4.46, acos(x) = sqrt(1-x)*poly(x) on [0,1], mirrored for x<0
+static const float acosCoef[8]={1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f,
+                                0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f};
+
+float acosApprox(float x){
+    float a=std::min(std::fabs(x),1.0f);
+    float p=acosCoef[7];
+    for(int i=6;i>=0;i--)
+        p=p*a+acosCoef[i];
+    float r=std::sqrt(1.0f-a)*p;
+    return x<0? PI_F-r : r;
+}
+
+static inline void triangleScalar(const vec3 *pts, const unsigned int *idx, unsigned int t,
+                                  vec3 *faceN, float *cornerW){
+    vec3 p0=pts[idx[3*t]];
+    vec3 p1=pts[idx[3*t+1]];
+    vec3 p2=pts[idx[3*t+2]];
+
+    faceN[t]=normalize(cross(p0-p1,p0-p2));
+    if(cornerW){
+        vec3 e01=normalize(p1-p0);
+        vec3 e02=normalize(p2-p0);
+        vec3 e12=normalize(p2-p1);
+        cornerW[3*t]  =acosApprox(dot(e01,e02));
+        cornerW[3*t+1]=acosApprox(dot(-e01,e12));
+        cornerW[3*t+2]=acosApprox(dot(e02,e12));
+    }
+}
+
+#ifdef MESH_SSE2
+
+// 4 triangles at a time, one per lane. Same operations in the same order as the scalar
+// path (no fused multiply-add), so the face normals come out bit for bit the same.
+struct V4{
+    __m128 x,y,z;
+};
+
+static inline V4 sub4(const V4 &a, const V4 &b){
+    V4 r={_mm_sub_ps(a.x,b.x), _mm_sub_ps(a.y,b.y), _mm_sub_ps(a.z,b.z)};
+    return r;
+}
+static inline __m128 dot4(const V4 &a, const V4 &b){
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x,b.x),_mm_mul_ps(a.y,b.y)),_mm_mul_ps(a.z,b.z));
+}
+static inline V4 normalize4(const V4 &a){
+    __m128 inv=_mm_div_ps(_mm_set1_ps(1.0f),_mm_sqrt_ps(dot4(a,a)));
+    V4 r={_mm_mul_ps(a.x,inv), _mm_mul_ps(a.y,inv), _mm_mul_ps(a.z,inv)};
+    return r;
+}
+static inline V4 cross4(const V4 &a, const V4 &b){
+    V4 r={_mm_sub_ps(_mm_mul_ps(a.y,b.z),_mm_mul_ps(b.y,a.z)),
+          _mm_sub_ps(_mm_mul_ps(a.z,b.x),_mm_mul_ps(b.z,a.x)),
+          _mm_sub_ps(_mm_mul_ps(a.x,b.y),_mm_mul_ps(b.x,a.y))};
+    return r;
+}
+static inline __m128 acos4(__m128 x){
+    __m128 neg=_mm_cmplt_ps(x,_mm_setzero_ps());
+    __m128 a=_mm_min_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f),x),_mm_set1_ps(1.0f));
+    __m128 p=_mm_set1_ps(acosCoef[7]);
+    for(int i=6;i>=0;i--)
+        p=_mm_add_ps(_mm_mul_ps(p,a),_mm_set1_ps(acosCoef[i]));
+    __m128 r=_mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f),a)),p);
+    __m128 m=_mm_sub_ps(_mm_set1_ps(PI_F),r);
+    return _mm_or_ps(_mm_and_ps(neg,m),_mm_andnot_ps(neg,r));
+}
+static inline V4 gather4(const vec3 *pts, const unsigned int *idx, unsigned int t, int corner){
+    const vec3 &a=pts[idx[3*t+corner]];
+    const vec3 &b=pts[idx[3*t+3+corner]];
+    const vec3 &c=pts[idx[3*t+6+corner]];
+    const vec3 &d=pts[idx[3*t+9+corner]];
+    V4 r={_mm_setr_ps(a.x,b.x,c.x,d.x), _mm_setr_ps(a.y,b.y,c.y,d.y), _mm_setr_ps(a.z,b.z,c.z,d.z)};
+    return r;
+}
+
+void triangleNormals(const vec3 *pts, const unsigned int *idx, unsigned int t0, unsigned int t1,
+                     vec3 *faceN, float *cornerW){
+    unsigned int t=t0;
+    for(;t+4<=t1;t+=4){
+        V4 p0=gather4(pts,idx,t,0);
+        V4 p1=gather4(pts,idx,t,1);
+        V4 p2=gather4(pts,idx,t,2);
+
+        V4 n=normalize4(cross4(sub4(p0,p1),sub4(p0,p2)));
+        float nx[4],ny[4],nz[4];
+        _mm_storeu_ps(nx,n.x);
+        _mm_storeu_ps(ny,n.y);
+        _mm_storeu_ps(nz,n.z);
+        for(int k=0;k<4;k++)
+            faceN[t+k]=vec3(nx[k],ny[k],nz[k]);
+
+        if(cornerW){
+            V4 e01=normalize4(sub4(p1,p0));
+            V4 e02=normalize4(sub4(p2,p0));
+            V4 e12=normalize4(sub4(p2,p1));
+            float w[3][4];
+            _mm_storeu_ps(w[0],acos4(dot4(e01,e02)));
+            _mm_storeu_ps(w[1],acos4(_mm_sub_ps(_mm_setzero_ps(),dot4(e01,e12))));
+            _mm_storeu_ps(w[2],acos4(dot4(e02,e12)));
+            for(int k=0;k<4;k++){
+                cornerW[3*(t+k)]  =w[0][k];
+                cornerW[3*(t+k)+1]=w[1][k];
+                cornerW[3*(t+k)+2]=w[2][k];
+            }
+        }
+    }
+    for(;t<t1;t++)
+        triangleScalar(pts,idx,t,faceN,cornerW);
+}
+
+#else
+
+void triangleNormals(const vec3 *pts, const unsigned int *idx, unsigned int t0, unsigned int t1,
+                     vec3 *faceN, float *cornerW){
+    for(unsigned int t=t0;t<t1;t++)
+        triangleScalar(pts,idx,t,faceN,cornerW);
+}
+
+#endif
+
+// ---- bulk vec3 transforms ----
+//
+// The scalar loops are the reference, the SIMD ones do the same float ops in the same order.
+// scale/translate don't care which component is which, so they run straight over the float
+// stream with the factor repeated in an x,y,z,x.. pattern. transform/normalize need x,y,z in
+// separate registers: 4 vec3s are 3 registers of floats, which get shuffled to x,y,z and back.
+
+static void scaleScalar(vec3 *p, unsigned int n, const vec3 &s){
+    for(unsigned int i=0;i<n;i++)
+        p[i]*=s;
+}
+static void translateScalar(vec3 *p, unsigned int n, const vec3 &t){
+    for(unsigned int i=0;i<n;i++)
+        p[i]+=t;
+}
+static void transformScalar(vec3 *pts, vec3 *nrm, unsigned int n, const glm::mat4 &m){
+    for(unsigned int i=0;i<n;i++){
+        pts[i]=vec3(m*glm::vec4(pts[i],1));
+        if(nrm)
+            nrm[i]=vec3(m*glm::vec4(nrm[i],0));
+    }
+}
+static void normalizeScalar(vec3 *p, unsigned int n, float len){
+    for(unsigned int i=0;i<n;i++)
+        p[i]=normalize(p[i])*len;
+}
+
+#ifdef MESH_SSE2
+
+// a,b,c = x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3  <->  x,y,z = x0..x3 | y0..y3 | z0..z3
+static inline void toXYZ(__m128 a, __m128 b, __m128 c, __m128 &x, __m128 &y, __m128 &z){
+    __m128 u=_mm_shuffle_ps(b,c,_MM_SHUFFLE(2,1,3,2));
+    __m128 v=_mm_shuffle_ps(a,b,_MM_SHUFFLE(3,0,1,1));
+    __m128 w=_mm_shuffle_ps(b,c,_MM_SHUFFLE(0,2,0,3));
+    __m128 t=_mm_shuffle_ps(a,b,_MM_SHUFFLE(1,1,2,2));
+    x=_mm_shuffle_ps(a,u,_MM_SHUFFLE(2,0,3,0));
+    y=_mm_shuffle_ps(v,w,_MM_SHUFFLE(2,0,2,0));
+    z=_mm_shuffle_ps(t,c,_MM_SHUFFLE(3,0,2,0));
+}
+static inline void fromXYZ(__m128 x, __m128 y, __m128 z, __m128 &a, __m128 &b, __m128 &c){
+    a=_mm_shuffle_ps(_mm_shuffle_ps(x,y,_MM_SHUFFLE(0,0,0,0)),
+                     _mm_shuffle_ps(z,x,_MM_SHUFFLE(1,1,0,0)),_MM_SHUFFLE(2,0,2,0));
+    b=_mm_shuffle_ps(_mm_shuffle_ps(y,z,_MM_SHUFFLE(1,1,1,1)),
+                     _mm_shuffle_ps(x,y,_MM_SHUFFLE(2,2,2,2)),_MM_SHUFFLE(2,0,2,0));
+    c=_mm_shuffle_ps(_mm_shuffle_ps(z,x,_MM_SHUFFLE(3,3,2,2)),
+                     _mm_shuffle_ps(y,z,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(2,0,2,0));
+}
+
+static void scaleSSE2(vec3 *p, unsigned int n, const vec3 &s){
+    float *f=&p[0].x;
+    __m128 s0=_mm_setr_ps(s.x,s.y,s.z,s.x);
+    __m128 s1=_mm_setr_ps(s.y,s.z,s.x,s.y);
+    __m128 s2=_mm_setr_ps(s.z,s.x,s.y,s.z);
+    unsigned int i=0;
+    for(;i+4<=n;i+=4,f+=12){
+        _mm_storeu_ps(f,  _mm_mul_ps(_mm_loadu_ps(f),  s0));
+        _mm_storeu_ps(f+4,_mm_mul_ps(_mm_loadu_ps(f+4),s1));
+        _mm_storeu_ps(f+8,_mm_mul_ps(_mm_loadu_ps(f+8),s2));
+    }
+    scaleScalar(p+i,n-i,s);
+}
+static void translateSSE2(vec3 *p, unsigned int n, const vec3 &t){
+    float *f=&p[0].x;
+    __m128 t0=_mm_setr_ps(t.x,t.y,t.z,t.x);
+    __m128 t1=_mm_setr_ps(t.y,t.z,t.x,t.y);
+    __m128 t2=_mm_setr_ps(t.z,t.x,t.y,t.z);
+    unsigned int i=0;
+    for(;i+4<=n;i+=4,f+=12){
+        _mm_storeu_ps(f,  _mm_add_ps(_mm_loadu_ps(f),  t0));
+        _mm_storeu_ps(f+4,_mm_add_ps(_mm_loadu_ps(f+4),t1));
+        _mm_storeu_ps(f+8,_mm_add_ps(_mm_loadu_ps(f+8),t2));
+    }
+    translateScalar(p+i,n-i,t);
+}
+
+// m*(x,y,z,w) as (m0*x + m1*y) + (m2*z + m3*w), the same grouping glm uses.
+// mc[c][r] is m[c][r] in every lane, with w already folded into column 3.
+static inline void loadMat4(const glm::mat4 &m, float w, __m128 mc[4][3]){
+    for(int c=0;c<4;c++)
+        for(int r=0;r<3;r++)
+            mc[c][r]=_mm_set1_ps(c==3? m[c][r]*w : m[c][r]);
+}
+static inline __m128 row4(__m128 mc[4][3], int r, __m128 x, __m128 y, __m128 z){
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(mc[0][r],x),_mm_mul_ps(mc[1][r],y)),
+                      _mm_add_ps(_mm_mul_ps(mc[2][r],z),mc[3][r]));
+}
+static inline void transform4(float *f, __m128 mc[4][3]){
+    __m128 x,y,z,a,b,c;
+    toXYZ(_mm_loadu_ps(f),_mm_loadu_ps(f+4),_mm_loadu_ps(f+8),x,y,z);
+    fromXYZ(row4(mc,0,x,y,z),row4(mc,1,x,y,z),row4(mc,2,x,y,z),a,b,c);
+    _mm_storeu_ps(f,a);
+    _mm_storeu_ps(f+4,b);
+    _mm_storeu_ps(f+8,c);
+}
+static void transformSSE2(vec3 *pts, vec3 *nrm, unsigned int n, const glm::mat4 &m){
+    __m128 mp[4][3],mn[4][3];
+    loadMat4(m,1.0f,mp);
+    loadMat4(m,0.0f,mn);
+    unsigned int i=0;
+    // points and normals in separate passes, one matrix at a time fits in the registers
+    for(;i+4<=n;i+=4)
+        transform4(&pts[i].x,mp);
+    if(nrm)
+        for(unsigned int j=0;j<i;j+=4)
+            transform4(&nrm[j].x,mn);
+    transformScalar(pts+i,nrm? nrm+i : 0,n-i,m);
+}
+static void normalizeSSE2(vec3 *p, unsigned int n, float len){
+    float *f=&p[0].x;
+    __m128 l=_mm_set1_ps(len);
+    unsigned int i=0;
+    for(;i+4<=n;i+=4,f+=12){
+        __m128 x,y,z,a,b,c;
+        toXYZ(_mm_loadu_ps(f),_mm_loadu_ps(f+4),_mm_loadu_ps(f+8),x,y,z);
+        __m128 d=_mm_add_ps(_mm_add_ps(_mm_mul_ps(x,x),_mm_mul_ps(y,y)),_mm_mul_ps(z,z));
+        __m128 inv=_mm_div_ps(_mm_set1_ps(1.0f),_mm_sqrt_ps(d));
+        fromXYZ(_mm_mul_ps(_mm_mul_ps(x,inv),l),_mm_mul_ps(_mm_mul_ps(y,inv),l),
+                _mm_mul_ps(_mm_mul_ps(z,inv),l),a,b,c);
+        _mm_storeu_ps(f,a);
+        _mm_storeu_ps(f+4,b);
+        _mm_storeu_ps(f+8,c);
+    }
+    normalizeScalar(p+i,n-i,len);
+}
+
+#endif // MESH_SSE2
+
+#ifdef MESH_AVX
+
+// Same as the SSE2 versions, 8 vec3s at a time. 256 bit shuffles work within each 128 bit
+// half, so vec3s 0-3 go in the low halves and 4-7 in the high halves and the same swizzle
+// works unchanged.
+#define AVX_FN __attribute__((target("avx")))
+
+AVX_FN static inline __m256 load8(const float *f){
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f)),_mm_loadu_ps(f+12),1);
+}
+AVX_FN static inline void store8(float *f, __m256 v){
+    _mm_storeu_ps(f,_mm256_castps256_ps128(v));
+    _mm_storeu_ps(f+12,_mm256_extractf128_ps(v,1));
+}
+AVX_FN static inline void toXYZ8(const float *f, __m256 &x, __m256 &y, __m256 &z){
+    __m256 a=load8(f), b=load8(f+4), c=load8(f+8);
+    __m256 u=_mm256_shuffle_ps(b,c,_MM_SHUFFLE(2,1,3,2));
+    __m256 v=_mm256_shuffle_ps(a,b,_MM_SHUFFLE(3,0,1,1));
+    __m256 w=_mm256_shuffle_ps(b,c,_MM_SHUFFLE(0,2,0,3));
+    __m256 t=_mm256_shuffle_ps(a,b,_MM_SHUFFLE(1,1,2,2));
+    x=_mm256_shuffle_ps(a,u,_MM_SHUFFLE(2,0,3,0));
+    y=_mm256_shuffle_ps(v,w,_MM_SHUFFLE(2,0,2,0));
+    z=_mm256_shuffle_ps(t,c,_MM_SHUFFLE(3,0,2,0));
+}
+AVX_FN static inline void fromXYZ8(float *f, __m256 x, __m256 y, __m256 z){
+    store8(f,  _mm256_shuffle_ps(_mm256_shuffle_ps(x,y,_MM_SHUFFLE(0,0,0,0)),
+                                 _mm256_shuffle_ps(z,x,_MM_SHUFFLE(1,1,0,0)),_MM_SHUFFLE(2,0,2,0)));
+    store8(f+4,_mm256_shuffle_ps(_mm256_shuffle_ps(y,z,_MM_SHUFFLE(1,1,1,1)),
+                                 _mm256_shuffle_ps(x,y,_MM_SHUFFLE(2,2,2,2)),_MM_SHUFFLE(2,0,2,0)));
+    store8(f+8,_mm256_shuffle_ps(_mm256_shuffle_ps(z,x,_MM_SHUFFLE(3,3,2,2)),
+                                 _mm256_shuffle_ps(y,z,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(2,0,2,0)));
+}
+
+AVX_FN static void scaleAVX(vec3 *p, unsigned int n, const vec3 &s){
+    float *f=&p[0].x;
+    __m256 s0=_mm256_setr_ps(s.x,s.y,s.z,s.x,s.y,s.z,s.x,s.y);
+    __m256 s1=_mm256_setr_ps(s.z,s.x,s.y,s.z,s.x,s.y,s.z,s.x);
+    __m256 s2=_mm256_setr_ps(s.y,s.z,s.x,s.y,s.z,s.x,s.y,s.z);
+    unsigned int i=0;
+    for(;i+8<=n;i+=8,f+=24){
+        _mm256_storeu_ps(f,   _mm256_mul_ps(_mm256_loadu_ps(f),   s0));
+        _mm256_storeu_ps(f+8, _mm256_mul_ps(_mm256_loadu_ps(f+8), s1));
+        _mm256_storeu_ps(f+16,_mm256_mul_ps(_mm256_loadu_ps(f+16),s2));
+    }
+    scaleScalar(p+i,n-i,s);
+}
+AVX_FN static void translateAVX(vec3 *p, unsigned int n, const vec3 &t){
+    float *f=&p[0].x;
+    __m256 t0=_mm256_setr_ps(t.x,t.y,t.z,t.x,t.y,t.z,t.x,t.y);
+    __m256 t1=_mm256_setr_ps(t.z,t.x,t.y,t.z,t.x,t.y,t.z,t.x);
+    __m256 t2=_mm256_setr_ps(t.y,t.z,t.x,t.y,t.z,t.x,t.y,t.z);
+    unsigned int i=0;
+    for(;i+8<=n;i+=8,f+=24){
+        _mm256_storeu_ps(f,   _mm256_add_ps(_mm256_loadu_ps(f),   t0));
+        _mm256_storeu_ps(f+8, _mm256_add_ps(_mm256_loadu_ps(f+8), t1));
+        _mm256_storeu_ps(f+16,_mm256_add_ps(_mm256_loadu_ps(f+16),t2));
+    }
+    translateScalar(p+i,n-i,t);
+}
+AVX_FN static inline void loadMat8(const glm::mat4 &m, float w, __m256 mc[4][3]){
+    for(int c=0;c<4;c++)
+        for(int r=0;r<3;r++)
+            mc[c][r]=_mm256_set1_ps(c==3? m[c][r]*w : m[c][r]);
+}
+AVX_FN static inline __m256 row8(__m256 mc[4][3], int r, __m256 x, __m256 y, __m256 z){
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(mc[0][r],x),_mm256_mul_ps(mc[1][r],y)),
+                         _mm256_add_ps(_mm256_mul_ps(mc[2][r],z),mc[3][r]));
+}
+AVX_FN static inline void transform8(float *f, __m256 mc[4][3]){
+    __m256 x,y,z;
+    toXYZ8(f,x,y,z);
+    fromXYZ8(f,row8(mc,0,x,y,z),row8(mc,1,x,y,z),row8(mc,2,x,y,z));
+}
+AVX_FN static void transformAVX(vec3 *pts, vec3 *nrm, unsigned int n, const glm::mat4 &m){
+    __m256 mp[4][3],mn[4][3];
+    loadMat8(m,1.0f,mp);
+    loadMat8(m,0.0f,mn);
+    unsigned int i=0;
+    for(;i+8<=n;i+=8)
+        transform8(&pts[i].x,mp);
+    if(nrm)
+        for(unsigned int j=0;j<i;j+=8)
+            transform8(&nrm[j].x,mn);
+    transformSSE2(pts+i,nrm? nrm+i : 0,n-i,m);
+}
+AVX_FN static void normalizeAVX(vec3 *p, unsigned int n, float len){
+    float *f=&p[0].x;
+    __m256 l=_mm256_set1_ps(len);
+    unsigned int i=0;
+    for(;i+8<=n;i+=8,f+=24){
+        __m256 x,y,z;
+        toXYZ8(f,x,y,z);
+        __m256 d=_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x,x),_mm256_mul_ps(y,y)),_mm256_mul_ps(z,z));
+        __m256 inv=_mm256_div_ps(_mm256_set1_ps(1.0f),_mm256_sqrt_ps(d));
+        fromXYZ8(f,_mm256_mul_ps(_mm256_mul_ps(x,inv),l),_mm256_mul_ps(_mm256_mul_ps(y,inv),l),
+                 _mm256_mul_ps(_mm256_mul_ps(z,inv),l));
+    }
+    normalizeSSE2(p+i,n-i,len);
+}
+
+#endif // MESH_AVX
+
+// ---- rounded box and roughen ----
+
+// scalar versions of the lane math below, same ops in the same order
+
+// edge along the third axis, u/v are the other two coordinates. Only moves the point if it
+// is past 1-radius in both u and v, and further than radius from the edge line.
+static inline void roundEdge(float &u, float &v, float a, float radius){
+    float cu=u<0? -a : a;
+    float cv=v<0? -a : a;
+    float du=u-cu;
+    float dv=v-cv;
+    float len=std::sqrt(du*du+dv*dv);
+    if(std::fabs(u)>a && std::fabs(v)>a && len>radius){
+        float rat=radius/len;
+        u=du*rat+cu;
+        v=dv*rat+cv;
+    }
+}
+static inline void roundBoxScalar(vec3 &p, float a, float radius){
+    roundEdge(p.x,p.y,a,radius);
+    roundEdge(p.z,p.y,a,radius);
+    roundEdge(p.z,p.x,a,radius);
+}
+
+static inline unsigned int hash32(unsigned int x){
+    x^=x>>16;
+    x*=0x7feb352du;
+    x^=x>>15;
+    x*=0x846ca68bu;
+    x^=x>>16;
+    return x;
+}
+// approximately normal, mean 0 sd 1: four 16 bit uniforms summed (Irwin-Hall)
+static inline float gaussHash(unsigned int key, unsigned int i){
+    unsigned int h0=hash32(i^key);
+    unsigned int h1=hash32(h0+0x9e3779b9u);
+    int s=(int)((h0&0xffff)+(h0>>16)+(h1&0xffff)+(h1>>16));
+    return ((float)s+2.0f)*(1.0f/65536)-2.0f;
+}
+// cos(pi*t) = -sin(pi*u), u=t-0.5 after folding t into [0,1], taylor to u^11 (~1e-7)
+static const float cosPiCoef[6]={-3.141592654f, 5.167712780f, -2.550164040f,
+                                 0.5992645293f, -0.08214588661f, 0.007370430946f};
+static inline float cosPi(float t){
+    t=std::fabs(t);
+    t=t-2.0f*(float)(int)(t*0.5f);
+    t=std::min(t,2.0f-t);
+    float u=t-0.5f;
+    float u2=u*u;
+    float p=cosPiCoef[5];
+    for(int i=4;i>=0;i--)
+        p=p*u2+cosPiCoef[i];
+    return u*p;
+}
+
+// per-call constants of roughen
+struct RoughParams{
+    unsigned int key;
+    float rough;     // sd of the noise
+    float waveZ;     // amplitude of the wave on front/back
+    float freqZ;     // wave is cos(pi*x*freqZ)
+    float waveX;
+    float freqX;
+};
+static RoughParams roughParams(float factor, int subdivides, unsigned int seed){
+    RoughParams rp;
+    rp.key=hash32(seed*0x9e3779b9u+0x632be5abu);
+    rp.rough=0.2f*factor*1.7320508f;   // sqrt(3) makes the sum of 4 uniforms unit variance
+    rp.waveZ=.04f*(subdivides==6? factor*.8f : factor);
+    rp.freqZ=std::ldexp(1.0f,subdivides-1);
+    rp.waveX=.02f*factor;
+    rp.freqX=std::ldexp(1.0f,subdivides-2);
+    return rp;
+}
+vec3 roughenAmplitude(float factor, int subdivides){
+    RoughParams rp=roughParams(factor,subdivides,0);
+    float sd=rp.rough/1.7320508f;
+    return vec3(sd*0.5f+rp.waveX,sd*0.1f,sd+rp.waveZ);
+}
+
+static inline void roughenScalar(vec3 &p, vec3 &c, const vec3 &n, unsigned int i, const RoughParams &rp){
+    float r=gaussHash(rp.key,i)*rp.rough;
+    bool isZ=std::fabs(n.z)>0.5f;
+    bool isX=!isZ && std::fabs(n.x)>0.5f;
+    bool isY=!isZ && !isX && std::fabs(n.y)>0.5f;
+
+    // front and back get a wave along x, ends a wave along z, top and bottom just noise
+    float pz=(p.z+cosPi(p.x*rp.freqZ)*rp.waveZ)+r;
+    float px=(p.x+cosPi(p.z*rp.freqX)*rp.waveX)+r*0.5f;
+    float py=p.y+r*0.1f;
+    // bumps out lighten, dents darken
+    float dz=pz-p.z;
+    float dx=px-p.x;
+    if(n.z<0.5f) dz=-dz;
+    if(n.x<0.5f) dx=-dx;
+    float dc=isZ? dz*5.0f : isX? dx*5.0f : 0.0f;
+
+    if(isZ) p.z=pz;
+    if(isX) p.x=px;
+    if(isY) p.y=py;
+    c+=vec3(dc);
+}
+
+#ifdef MESH_SSE2
+
+static inline __m128 abs4(__m128 x){
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f),x);
+}
+static inline __m128 select4(__m128 m, __m128 a, __m128 b){
+    return _mm_or_ps(_mm_and_ps(m,a),_mm_andnot_ps(m,b));
+}
+static inline void roundEdge4(__m128 &u, __m128 &v, __m128 a, __m128 radius){
+    __m128 sign=_mm_set1_ps(-0.0f);
+    __m128 cu=_mm_or_ps(a,_mm_and_ps(u,sign));
+    __m128 cv=_mm_or_ps(a,_mm_and_ps(v,sign));
+    __m128 du=_mm_sub_ps(u,cu);
+    __m128 dv=_mm_sub_ps(v,cv);
+    __m128 len=_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(du,du),_mm_mul_ps(dv,dv)));
+    __m128 m=_mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(abs4(u),a),_mm_cmpgt_ps(abs4(v),a)),
+                        _mm_cmpgt_ps(len,radius));
+    __m128 rat=_mm_div_ps(radius,len);
+    u=select4(m,_mm_add_ps(_mm_mul_ps(du,rat),cu),u);
+    v=select4(m,_mm_add_ps(_mm_mul_ps(dv,rat),cv),v);
+}
+
+void roundBoxVec3(vec3 *p, unsigned int n, float radius){
+    float a=1-radius;
+    __m128 a4=_mm_set1_ps(a), r4=_mm_set1_ps(radius);
+    float *f=&p[0].x;
+    unsigned int i=0;
+    for(;i+4<=n;i+=4,f+=12){
+        __m128 x,y,z,o0,o1,o2;
+        toXYZ(_mm_loadu_ps(f),_mm_loadu_ps(f+4),_mm_loadu_ps(f+8),x,y,z);
+        roundEdge4(x,y,a4,r4);
+        roundEdge4(z,y,a4,r4);
+        roundEdge4(z,x,a4,r4);
+        fromXYZ(x,y,z,o0,o1,o2);
+        _mm_storeu_ps(f,o0);
+        _mm_storeu_ps(f+4,o1);
+        _mm_storeu_ps(f+8,o2);
+    }
+    for(;i<n;i++)
+        roundBoxScalar(p[i],a,radius);
+}
+
+// SSE2 has no 32 bit multiply-low, build it from the two 32x32->64 ones
+static inline __m128i mullo4(__m128i a, __m128i b){
+    __m128i even=_mm_mul_epu32(a,b);
+    __m128i odd=_mm_mul_epu32(_mm_srli_epi64(a,32),_mm_srli_epi64(b,32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even,_MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(odd,_MM_SHUFFLE(0,0,2,0)));
+}
+static inline __m128i hash4(__m128i x){
+    x=_mm_xor_si128(x,_mm_srli_epi32(x,16));
+    x=mullo4(x,_mm_set1_epi32((int)0x7feb352du));
+    x=_mm_xor_si128(x,_mm_srli_epi32(x,15));
+    x=mullo4(x,_mm_set1_epi32((int)0x846ca68bu));
+    x=_mm_xor_si128(x,_mm_srli_epi32(x,16));
+    return x;
+}
+static inline __m128 gaussHash4(unsigned int key, unsigned int i){
+    __m128i lo=_mm_set1_epi32(0xffff);
+    __m128i h0=hash4(_mm_xor_si128(_mm_setr_epi32(i,i+1,i+2,i+3),_mm_set1_epi32(key)));
+    __m128i h1=hash4(_mm_add_epi32(h0,_mm_set1_epi32((int)0x9e3779b9u)));
+    __m128i s=_mm_add_epi32(_mm_add_epi32(_mm_and_si128(h0,lo),_mm_srli_epi32(h0,16)),
+                            _mm_add_epi32(_mm_and_si128(h1,lo),_mm_srli_epi32(h1,16)));
+    return _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(s),_mm_set1_ps(2.0f)),
+                                 _mm_set1_ps(1.0f/65536)),_mm_set1_ps(2.0f));
+}
+static inline __m128 cosPi4(__m128 t){
+    t=abs4(t);
+    __m128 k=_mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(t,_mm_set1_ps(0.5f))));
+    t=_mm_sub_ps(t,_mm_mul_ps(_mm_set1_ps(2.0f),k));
+    t=_mm_min_ps(t,_mm_sub_ps(_mm_set1_ps(2.0f),t));
+    __m128 u=_mm_sub_ps(t,_mm_set1_ps(0.5f));
+    __m128 u2=_mm_mul_ps(u,u);
+    __m128 p=_mm_set1_ps(cosPiCoef[5]);
+    for(int i=4;i>=0;i--)
+        p=_mm_add_ps(_mm_mul_ps(p,u2),_mm_set1_ps(cosPiCoef[i]));
+    return _mm_mul_ps(u,p);
+}
+static inline void load4(const vec3 *v, __m128 &x, __m128 &y, __m128 &z){
+    const float *f=&v[0].x;
+    toXYZ(_mm_loadu_ps(f),_mm_loadu_ps(f+4),_mm_loadu_ps(f+8),x,y,z);
+}
+static inline void store4(vec3 *v, __m128 x, __m128 y, __m128 z){
+    float *f=&v[0].x;
+    __m128 a,b,c;
+    fromXYZ(x,y,z,a,b,c);
+    _mm_storeu_ps(f,a);
+    _mm_storeu_ps(f+4,b);
+    _mm_storeu_ps(f+8,c);
+}
+
+void roughenVerts(vec3 *pts, vec3 *colors, const vec3 *normals, unsigned int v0, unsigned int v1,
+                  float factor, int subdivides, unsigned int seed){
+    RoughParams rp=roughParams(factor,subdivides,seed);
+    __m128 half=_mm_set1_ps(0.5f), sign=_mm_set1_ps(-0.0f);
+    unsigned int i=v0;
+    for(;i+4<=v1;i+=4){
+        __m128 x,y,z,nx,ny,nz,cr,cg,cb;
+        load4(pts+i,x,y,z);
+        load4(normals+i,nx,ny,nz);
+        load4(colors+i,cr,cg,cb);
+
+        __m128 r=_mm_mul_ps(gaussHash4(rp.key,i),_mm_set1_ps(rp.rough));
+        __m128 isZ=_mm_cmpgt_ps(abs4(nz),half);
+        __m128 isX=_mm_andnot_ps(isZ,_mm_cmpgt_ps(abs4(nx),half));
+        __m128 isY=_mm_andnot_ps(_mm_or_ps(isZ,isX),_mm_cmpgt_ps(abs4(ny),half));
+
+        __m128 pz=_mm_add_ps(_mm_add_ps(z,_mm_mul_ps(cosPi4(_mm_mul_ps(x,_mm_set1_ps(rp.freqZ))),
+                                                     _mm_set1_ps(rp.waveZ))),r);
+        __m128 px=_mm_add_ps(_mm_add_ps(x,_mm_mul_ps(cosPi4(_mm_mul_ps(z,_mm_set1_ps(rp.freqX))),
+                                                     _mm_set1_ps(rp.waveX))),
+                             _mm_mul_ps(r,half));
+        __m128 py=_mm_add_ps(y,_mm_mul_ps(r,_mm_set1_ps(0.1f)));
+        __m128 dz=_mm_xor_ps(_mm_sub_ps(pz,z),_mm_and_ps(_mm_cmplt_ps(nz,half),sign));
+        __m128 dx=_mm_xor_ps(_mm_sub_ps(px,x),_mm_and_ps(_mm_cmplt_ps(nx,half),sign));
+        __m128 five=_mm_set1_ps(5.0f);
+        __m128 dc=select4(isZ,_mm_mul_ps(dz,five),_mm_and_ps(isX,_mm_mul_ps(dx,five)));
+
+        store4(pts+i,select4(isX,px,x),select4(isY,py,y),select4(isZ,pz,z));
+        store4(colors+i,_mm_add_ps(cr,dc),_mm_add_ps(cg,dc),_mm_add_ps(cb,dc));
+    }
+    for(;i<v1;i++)
+        roughenScalar(pts[i],colors[i],normals[i],i,rp);
+}
+
+#else
+
+void roundBoxVec3(vec3 *p, unsigned int n, float radius){
+    for(unsigned int i=0;i<n;i++)
+        roundBoxScalar(p[i],1-radius,radius);
+}
+void roughenVerts(vec3 *pts, vec3 *colors, const vec3 *normals, unsigned int v0, unsigned int v1,
+                  float factor, int subdivides, unsigned int seed){
+    RoughParams rp=roughParams(factor,subdivides,seed);
+    for(unsigned int i=v0;i<v1;i++)
+        roughenScalar(pts[i],colors[i],normals[i],i,rp);
+}
+
+#endif // MESH_SSE2
+
+struct Vec3Kernels{
+    void (*scale)(vec3*, unsigned int, const vec3&);
+    void (*translate)(vec3*, unsigned int, const vec3&);
+    void (*transform)(vec3*, vec3*, unsigned int, const glm::mat4&);
+    void (*normalize)(vec3*, unsigned int, float);
+    const char *name;
+};
+
+static Vec3Kernels pickKernels(){
+#ifdef MESH_AVX
+    if(__builtin_cpu_supports("avx")){
+        Vec3Kernels k={scaleAVX,translateAVX,transformAVX,normalizeAVX,"avx"};
+        return k;
+    }
+#endif
+#ifdef MESH_SSE2
+    Vec3Kernels k={scaleSSE2,translateSSE2,transformSSE2,normalizeSSE2,"sse2"};
+#else
+    Vec3Kernels k={scaleScalar,translateScalar,transformScalar,normalizeScalar,"scalar"};
+#endif
+    return k;
+}
+static const Vec3Kernels &kernels(){
+    static const Vec3Kernels k=pickKernels();
+    return k;
+}
+
+void scaleVec3(vec3 *p, unsigned int n, const vec3 &s){ kernels().scale(p,n,s); }
+void translateVec3(vec3 *p, unsigned int n, const vec3 &t){ kernels().translate(p,n,t); }
+void transformVec3(vec3 *pts, vec3 *nrm, unsigned int n, const glm::mat4 &m){ kernels().transform(pts,nrm,n,m); }
+void normalizeVec3(vec3 *p, unsigned int n, float len){ kernels().normalize(p,n,len); }
+const char* vec3KernelName(){ return kernels().name; }
+
+void frustumPlanes(const glm::mat4 &m, glm::vec4 planes[6]){
+    // rows of m, glm stores columns
+    glm::vec4 row[4];
+    for(int i=0;i<4;i++)
+        row[i]=glm::vec4(m[0][i],m[1][i],m[2][i],m[3][i]);
+    for(int i=0;i<3;i++){
+        planes[2*i]  =row[3]+row[i];
+        planes[2*i+1]=row[3]-row[i];
+    }
+    for(int i=0;i<6;i++)
+        planes[i]/=glm::length(vec3(planes[i]));
+}
+
+static inline bool sphereInside(float x, float y, float z, float r, const glm::vec4 planes[6]){
+    for(int p=0;p<6;p++){
+        if(planes[p].x*x+planes[p].y*y+planes[p].z*z+planes[p].w < -r)
+            return false;
+    }
+    return true;
+}
+
+unsigned int cullSpheres(const float *x, const float *y, const float *z, const float *r,
+                         unsigned int n, const glm::vec4 planes[6], unsigned int *visible){
+    unsigned int nVis=0;
+    unsigned int i=0;
+#ifdef MESH_SSE2
+    __m128 px[6],py[6],pz[6],pw[6];
+    for(int p=0;p<6;p++){
+        px[p]=_mm_set1_ps(planes[p].x);
+        py[p]=_mm_set1_ps(planes[p].y);
+        pz[p]=_mm_set1_ps(planes[p].z);
+        pw[p]=_mm_set1_ps(planes[p].w);
+    }
+    for(;i+4<=n;i+=4){
+        __m128 sx=_mm_loadu_ps(x+i), sy=_mm_loadu_ps(y+i), sz=_mm_loadu_ps(z+i);
+        __m128 nr=_mm_sub_ps(_mm_setzero_ps(),_mm_loadu_ps(r+i));
+        // same sums in the same order as sphereInside
+        __m128 in=_mm_castsi128_ps(_mm_set1_epi32(-1));
+        for(int p=0;p<6;p++){
+            __m128 d=_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p],sx),_mm_mul_ps(py[p],sy)),
+                                           _mm_mul_ps(pz[p],sz)),pw[p]);
+            in=_mm_and_ps(in,_mm_cmpge_ps(d,nr));
+        }
+        int mask=_mm_movemask_ps(in);
+        for(int k=0;k<4;k++){
+            if(mask&(1<<k))
+                visible[nVis++]=i+k;
+        }
+    }
+#endif
+    for(;i<n;i++){
+        if(sphereInside(x[i],y[i],z[i],r[i],planes))
+            visible[nVis++]=i;
+    }
+    return nVis;
+}
+
+// spreads the low 10 bits of v out to every third bit
+static inline unsigned int spreadBits(unsigned int v){
+    v&=0x3ff;
+    v=(v|(v<<16))&0x030000ff;
+    v=(v|(v<<8)) &0x0300f00f;
+    v=(v|(v<<4)) &0x030c30c3;
+    v=(v|(v<<2)) &0x09249249;
+    return v;
+}
+
+unsigned int mortonCode(const glm::vec3 &p){
+    glm::vec3 q=glm::clamp(p,0.0f,1.0f)*1023.0f;
+    return (spreadBits((unsigned int)q.x)<<2)|(spreadBits((unsigned int)q.y)<<1)|spreadBits((unsigned int)q.z);
+}
@@ -0,0 +1,63 @@
+#ifndef MESHKERNELS_H
+#define MESHKERNELS_H
+
+// meshkernels.h
+// Bulk per-vertex / per-triangle loops used by Mesh, written to work on plain arrays so
+// they can be split across threads and run several elements per SIMD register.
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define MESH_SSE2 1
+#endif
+
+// face normal of triangles [t0,t1) into faceN[t], and if cornerW is not null, the angle of
+// each corner into cornerW[3t..3t+2] (used to weight the face normal at that vertex).
+void triangleNormals(const glm::vec3 *pts, const unsigned int *idx,
+                     unsigned int t0, unsigned int t1,
+                     glm::vec3 *faceN, float *cornerW);
+
+// acos for x in [-1,1] without a libm call, good to about 1e-7.
+float acosApprox(float x);
+
+// Bulk transforms of n vec3s in place. The data stays in the usual interleaved vec3 layout
+// (that is what gets uploaded), blocks of 4 or 8 are swizzled to x/y/z registers on the fly.
+// The AVX or SSE2 version is picked at runtime, results match the plain glm loop exactly.
+void scaleVec3(glm::vec3 *p, unsigned int n, const glm::vec3 &s);
+void translateVec3(glm::vec3 *p, unsigned int n, const glm::vec3 &t);
+// pts as points (w=1), nrm as directions (w=0), nrm may be null
+void transformVec3(glm::vec3 *pts, glm::vec3 *nrm, unsigned int n, const glm::mat4 &m);
+// p=normalize(p)*len
+void normalizeVec3(glm::vec3 *p, unsigned int n, float len);
+
+// Push points of the [-1,1] box out onto a box with edges rounded to the given radius.
+// Works on the twelve edges directly from the signs of the coordinates, no per-edge branches.
+void roundBoxVec3(glm::vec3 *p, unsigned int n, float radius);
+
+// Brick surface noise for vertices [v0,v1): a wave across the face plus gaussian noise,
+// picked by which way the normal points, and the colors darkened/lightened to match.
+// The noise comes from a hash of (seed, vertex index), so the result only depends on the
+// inputs, not on the thread split or on whether the SIMD path ran.
+void roughenVerts(glm::vec3 *pts, glm::vec3 *colors, const glm::vec3 *normals,
+                  unsigned int v0, unsigned int v1, float factor, int subdivides, unsigned int seed);
+
+// how far roughenVerts moves the faces facing x, y and z: the noise sd plus the wave amplitude
+glm::vec3 roughenAmplitude(float factor, int subdivides);
+
+// The six planes of the frustum clip=m*p, as (n,d) with dot(n,p)+d>=0 inside and |n|=1.
+void frustumPlanes(const glm::mat4 &m, glm::vec4 planes[6]);
+// Spheres [0,n), given as x, y, z and radius arrays, tested against the planes four at a
+// time. The indices of the ones at least partly inside go into visible, in order, and the
+// count is returned. Spheres that only reach a corner outside the frustum count as inside.
+unsigned int cullSpheres(const float *x, const float *y, const float *z, const float *r,
+                         unsigned int n, const glm::vec4 planes[6], unsigned int *visible);
+
+// 30 bit Morton (z-order) code of a point in the unit cube, 10 bits per axis. Sorting by it
+// keeps points that are close together close in the order.
+unsigned int mortonCode(const glm::vec3 &p);
+
+// which of the bulk transforms got picked, "avx", "sse2" or "scalar"
+const char* vec3KernelName();
+
+#endif // MESHKERNELS_H
@@ -0,0 +1,167 @@
+
+#include "meshoptimize.h"
+#include <cmath>
+#include <algorithm>
+
+// Forsyth's scoring: a vertex is worth more the more recently it was used (the last
+// triangle's three a bit less, to avoid strips that turn back on themselves) and the
+// fewer triangles it has left, so lone vertices get finished off instead of stranded.
+#define CACHE_SIZE 32
+#define MAX_VALENCE 32
+
+struct ScoreTables{
+    float cache[CACHE_SIZE];
+    float valence[MAX_VALENCE];
+    ScoreTables(){
+        for(int i=0;i<CACHE_SIZE;i++)
+            cache[i]= i<3? 0.75f : std::pow(1.0f-(i-3)/(float)(CACHE_SIZE-3),1.5f);
+        valence[0]=0;
+        for(int i=1;i<MAX_VALENCE;i++)
+            valence[i]=2.0f/std::sqrt((float)i);
+    }
+};
+
+static inline float vertexScore(const ScoreTables &s, int cachePos, unsigned int active){
+    if(active==0)
+        return -1.0f;
+    float score= cachePos<0? 0.0f : s.cache[cachePos];
+    return score+s.valence[std::min(active,(unsigned int)MAX_VALENCE-1)];
+}
+
+void optimizeVertexCache(unsigned int *idx, unsigned int nIdx, unsigned int nVerts,
+                         MeshArena &scratch){
+    static const ScoreTables scores;
+    unsigned int nTri=nIdx/3;
+    if(nTri<2)
+        return;
+
+    // vertex -> triangles using it. The first active[v] entries of each list are the
+    // triangles not emitted yet.
+    unsigned int *triStart=scratch.alloc<unsigned int>(nVerts+1,0);
+    unsigned int *vertTris=scratch.alloc<unsigned int>(nTri*3);
+    unsigned int *active=scratch.alloc<unsigned int>(nVerts,0);
+    for(unsigned int i=0;i<nTri*3;i++)
+        active[idx[i]]++;
+    for(unsigned int v=0;v<nVerts;v++)
+        triStart[v+1]=triStart[v]+active[v];
+    unsigned int *fill=scratch.alloc<unsigned int>(nVerts);
+    std::copy(triStart,triStart+nVerts,fill);
+    for(unsigned int i=0;i<nTri*3;i++)
+        vertTris[fill[idx[i]]++]=i/3;
+
+    int *cachePos=scratch.alloc<int>(nVerts,-1);
+    float *vScore=scratch.alloc<float>(nVerts);
+    for(unsigned int v=0;v<nVerts;v++)
+        vScore[v]=vertexScore(scores,-1,active[v]);
+    float *tScore=scratch.alloc<float>(nTri);
+    int best=0;
+    for(unsigned int t=0;t<nTri;t++){
+        tScore[t]=vScore[idx[3*t]]+vScore[idx[3*t+1]]+vScore[idx[3*t+2]];
+        if(tScore[t]>tScore[best])
+            best=t;
+    }
+
+    char *emitted=scratch.alloc<char>(nTri,0);
+    unsigned int *out=scratch.alloc<unsigned int>(nTri*3);
+    unsigned int cache[CACHE_SIZE+3];
+    unsigned int newCache[CACHE_SIZE+3];
+    int cacheUsed=0;
+    unsigned int scan=0;
+
+    for(unsigned int n=0;n<nTri;n++){
+        // nothing in the cache touches a triangle that's left, start over somewhere new
+        if(best<0){
+            while(emitted[scan])
+                scan++;
+            best=scan;
+        }
+        unsigned int t=best;
+        const unsigned int *tv=idx+3*t;
+        emitted[t]=1;
+        out[3*n]=tv[0];
+        out[3*n+1]=tv[1];
+        out[3*n+2]=tv[2];
+
+        // take t out of its vertices' active lists
+        for(int c=0;c<3;c++){
+            unsigned int v=tv[c];
+            unsigned int *list=&vertTris[triStart[v]];
+            unsigned int last=--active[v];
+            for(unsigned int k=0;k<=last;k++)
+                if(list[k]==t){
+                    std::swap(list[k],list[last]);
+                    break;
+                }
+        }
+
+        // LRU: t's vertices go to the front
+        int newUsed=0;
+        for(int c=0;c<3;c++)
+            newCache[newUsed++]=tv[c];
+        for(int i=0;i<cacheUsed;i++){
+            unsigned int v=cache[i];
+            if(v!=tv[0] && v!=tv[1] && v!=tv[2])
+                newCache[newUsed++]=v;
+        }
+
+        // rescore everything in the cache and whatever just fell out of it, then the
+        // triangles around them, and pick the best of those next
+        for(int i=0;i<newUsed;i++){
+            unsigned int v=newCache[i];
+            cachePos[v]= i<CACHE_SIZE? i : -1;
+            vScore[v]=vertexScore(scores,cachePos[v],active[v]);
+        }
+        best=-1;
+        float bestScore=-1;
+        for(int i=0;i<newUsed;i++){
+            unsigned int v=newCache[i];
+            const unsigned int *list=&vertTris[triStart[v]];
+            for(unsigned int k=0;k<active[v];k++){
+                unsigned int tt=list[k];
+                float s=vScore[idx[3*tt]]+vScore[idx[3*tt+1]]+vScore[idx[3*tt+2]];
+                tScore[tt]=s;
+                if(s>bestScore){
+                    bestScore=s;
+                    best=tt;
+                }
+            }
+        }
+
+        cacheUsed=std::min(newUsed,CACHE_SIZE);
+        std::copy(newCache,newCache+cacheUsed,cache);
+    }
+    std::copy(out,out+nTri*3,idx);
+}
+
+void optimizeVertexFetch(unsigned int *idx, unsigned int nIdx, unsigned int nVerts,
+                         unsigned int *remap){
+    const unsigned int unused=~0u;
+    std::fill(remap,remap+nVerts,unused);
+    unsigned int next=0;
+    for(unsigned int i=0;i<nIdx;i++){
+        unsigned int &r=remap[idx[i]];
+        if(r==unused)
+            r=next++;
+        idx[i]=r;
+    }
+    for(unsigned int v=0;v<nVerts;v++)
+        if(remap[v]==unused)
+            remap[v]=next++;
+}
+
+float computeACMR(const unsigned int *idx, unsigned int nIdx, unsigned int nVerts,
+                  unsigned int cacheSize, MeshArena &scratch){
+    if(nIdx<3)
+        return 0;
+    // a vertex is still in the FIFO if fewer than cacheSize misses happened since it went in
+    unsigned int *loadedAt=scratch.alloc<unsigned int>(nVerts,0);
+    unsigned int misses=0;
+    for(unsigned int i=0;i<nIdx;i++){
+        unsigned int v=idx[i];
+        if(loadedAt[v]==0 || misses-loadedAt[v]>=cacheSize){
+            misses++;
+            loadedAt[v]=misses;
+        }
+    }
+    return misses/(float)(nIdx/3);
+}
@@ -0,0 +1,26 @@
+#ifndef MESHOPTIMIZE_H
+#define MESHOPTIMIZE_H
+
+// meshoptimize.h
+// Index/vertex reordering so the GPU transforms each vertex as few times as possible
+// (post-transform cache) and reads the vertex buffer roughly in order (pre-transform fetch).
+// Temporary arrays come from scratch, see mesharena.h.
+
+#include "mesharena.h"
+
+// Reorders the triangles in idx for a small LRU vertex cache, after Tom Forsyth's
+// "Linear-Speed Vertex Cache Optimisation". Triangle winding is kept.
+void optimizeVertexCache(unsigned int *idx, unsigned int nIdx, unsigned int nVerts,
+                         MeshArena &scratch);
+
+// Renumbers the vertices in the order the index buffer first uses them and rewrites idx.
+// remap[old]=new, nVerts of them; vertices no triangle uses go at the end in their old order.
+void optimizeVertexFetch(unsigned int *idx, unsigned int nIdx, unsigned int nVerts,
+                         unsigned int *remap);
+
+// Average cache miss ratio: vertices transformed per triangle with a FIFO cache of
+// cacheSize entries. 3 is no reuse at all, about 0.5-0.7 is good for a grid.
+float computeACMR(const unsigned int *idx, unsigned int nIdx, unsigned int nVerts,
+                  unsigned int cacheSize, MeshArena &scratch);
+
+#endif // MESHOPTIMIZE_H
@@ -0,0 +1,263 @@
+
+#include "meshsimplify.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <stdint.h>
+
+using glm::vec3;
+using std::vector;
+
+// sum of squared distances to a set of planes, weighted by triangle area:
+// Q(p) = p'Ap + 2b'p + c, A symmetric so only 6 entries are kept
+class Quadric{
+    public:
+        double a00,a01,a02,a11,a12,a22;
+        double b0,b1,b2;
+        double c;
+        double w;
+
+        Quadric(){ memset(this,0,sizeof(*this)); }
+
+        void addPlane(const vec3 &n, double d, double weight){
+            a00+=weight*n.x*n.x; a01+=weight*n.x*n.y; a02+=weight*n.x*n.z;
+            a11+=weight*n.y*n.y; a12+=weight*n.y*n.z; a22+=weight*n.z*n.z;
+            b0+=weight*n.x*d; b1+=weight*n.y*d; b2+=weight*n.z*d;
+            c+=weight*d*d;
+            w+=weight;
+        }
+        void add(const Quadric &q){
+            a00+=q.a00; a01+=q.a01; a02+=q.a02; a11+=q.a11; a12+=q.a12; a22+=q.a22;
+            b0+=q.b0; b1+=q.b1; b2+=q.b2;
+            c+=q.c;
+            w+=q.w;
+        }
+        // weighted average squared distance of p to the planes
+        double error(const vec3 &p) const {
+            double x=p.x,y=p.y,z=p.z;
+            double e=a00*x*x+a11*y*y+a22*z*z+2*(a01*x*y+a02*x*z+a12*y*z)
+                    +2*(b0*x+b1*y+b2*z)+c;
+            return w>0? std::max(0.0,e)/w : 0;
+        }
+};
+
+class Collapse{
+    public:
+        float cost;
+        unsigned int from,to;
+        bool operator<(const Collapse &o) const { return cost<o.cost; }
+};
+
+static inline uint64_t edgeKey(unsigned int a, unsigned int b){
+    return a<b ? ((uint64_t)a<<32)|b : ((uint64_t)b<<32)|a;
+}
+
+// would replacing from with to in the triangles around from turn any of them over,
+// or glue two sheets together (more than two shared neighbours)?
+static bool collapseOk(const vec3 *pts, const vector<unsigned int> &idx,
+                       const unsigned int *fromTris, unsigned int nFrom,
+                       const unsigned int *toTris, unsigned int nTo,
+                       unsigned int from, unsigned int to){
+    unsigned int shared=0;
+    for(unsigned int i=0;i<nFrom;i++){
+        const unsigned int *t=&idx[3*fromTris[i]];
+        if(t[0]==to || t[1]==to || t[2]==to)
+            continue;
+        vec3 p[3],q[3];
+        for(int c=0;c<3;c++){
+            p[c]=pts[t[c]];
+            q[c]= t[c]==from? pts[to] : p[c];
+        }
+        vec3 n0=glm::cross(p[1]-p[0],p[2]-p[0]);
+        vec3 n1=glm::cross(q[1]-q[0],q[2]-q[0]);
+        if(glm::dot(n0,n1)<=0)
+            return false;
+    }
+    // the link condition: from and to may only share the two vertices across their edge
+    for(unsigned int i=0;i<nFrom;i++){
+        const unsigned int *t=&idx[3*fromTris[i]];
+        for(int c=0;c<3;c++){
+            unsigned int v=t[c];
+            if(v==from || v==to)
+                continue;
+            bool seen=false;
+            for(unsigned int k=0;k<i && !seen;k++){
+                const unsigned int *s=&idx[3*fromTris[k]];
+                seen= s[0]==v || s[1]==v || s[2]==v;
+            }
+            if(seen)
+                continue;
+            for(unsigned int j=0;j<nTo;j++){
+                const unsigned int *s=&idx[3*toTris[j]];
+                if(s[0]==v || s[1]==v || s[2]==v){
+                    shared++;
+                    break;
+                }
+            }
+        }
+    }
+    return shared<=2;
+}
+
+float simplifyMesh(const vec3 *pts, unsigned int nVerts, vector<unsigned int> &idx,
+                   unsigned int targetTris, float maxError, MeshArena &scratch){
+    unsigned int nTri=idx.size()/3;
+    double maxCost=(double)maxError*maxError;
+
+    // seams: more than one vertex at a position. Borders: edges only one triangle uses.
+    // Both by sorting, so equal positions and the two sides of an edge end up next to
+    // each other.
+    char *locked=scratch.alloc<char>(nVerts,0);
+    {
+        unsigned int *byPos=scratch.alloc<unsigned int>(nVerts);
+        for(unsigned int v=0;v<nVerts;v++)
+            byPos[v]=v;
+        std::sort(byPos,byPos+nVerts,[&](unsigned int a, unsigned int b){
+            const vec3 &p=pts[a],&q=pts[b];
+            return p.x<q.x || (p.x==q.x && (p.y<q.y || (p.y==q.y && p.z<q.z)));
+        });
+        for(unsigned int i=1;i<nVerts;i++)
+            if(pts[byPos[i]]==pts[byPos[i-1]])
+                locked[byPos[i]]=locked[byPos[i-1]]=1;
+
+        uint64_t *edges=scratch.alloc<uint64_t>(nTri*3);
+        for(unsigned int i=0;i<nTri*3;i++)
+            edges[i]=edgeKey(idx[i],idx[i/3*3+(i+1)%3]);
+        std::sort(edges,edges+nTri*3);
+        for(unsigned int i=0;i<nTri*3;){
+            unsigned int n=1;
+            while(i+n<nTri*3 && edges[i+n]==edges[i])
+                n++;
+            if(n!=2)
+                locked[edges[i]>>32]=locked[(unsigned int)edges[i]]=1;
+            i+=n;
+        }
+    }
+
+    // The quadrics only rank the collapses, they give an area weighted mean. For the real
+    // distance every vertex also keeps a list of the original triangles it stands for,
+    // their planes tested against where it goes: node 3t+c is triangle t in the list of
+    // its corner c, lists are joined when their vertices are.
+    Quadric *quadrics=scratch.alloc<Quadric>(nVerts,Quadric());
+    glm::vec4 *planes=scratch.alloc<glm::vec4>(nTri);
+    unsigned int *head=scratch.alloc<unsigned int>(nVerts,~0u);
+    unsigned int *tail=scratch.alloc<unsigned int>(nVerts,~0u);
+    unsigned int *next=scratch.alloc<unsigned int>(nTri*3,~0u);
+    for(unsigned int t=0;t<nTri;t++){
+        const unsigned int *v=&idx[3*t];
+        vec3 n=glm::cross(pts[v[1]]-pts[v[0]],pts[v[2]]-pts[v[0]]);
+        float len=glm::length(n);
+        if(len<=0){
+            planes[t]=glm::vec4(0,0,0,0);
+            continue;
+        }
+        n/=len;
+        planes[t]=glm::vec4(n,-glm::dot(n,pts[v[0]]));
+        for(int c=0;c<3;c++){
+            quadrics[v[c]].addPlane(n,-glm::dot(n,pts[v[0]]),0.5*len);
+            unsigned int node=3*t+c;
+            if(head[v[c]]==~0u)
+                head[v[c]]=node;
+            else
+                next[tail[v[c]]]=node;
+            tail[v[c]]=node;
+        }
+    }
+
+    float worst=0;
+    // sized for the first pass, every pass after it has fewer triangles
+    unsigned int *triStart=scratch.alloc<unsigned int>(nVerts+1);
+    unsigned int *fill=scratch.alloc<unsigned int>(nVerts);
+    unsigned int *vertTris=scratch.alloc<unsigned int>(nTri*3);
+    unsigned int *remap=scratch.alloc<unsigned int>(nVerts);
+    char *dirty=scratch.alloc<char>(nVerts);
+    ArenaVector<Collapse> collapses(scratch);
+    collapses.reserve(nTri*6);
+    // each pass collapses the cheapest edges that don't touch each other, then rebuilds
+    while(nTri>targetTris){
+        std::fill(triStart,triStart+nVerts+1,0);
+        for(unsigned int i=0;i<nTri*3;i++)
+            triStart[idx[i]+1]++;
+        for(unsigned int v=0;v<nVerts;v++)
+            triStart[v+1]+=triStart[v];
+        std::copy(triStart,triStart+nVerts,fill);
+        for(unsigned int i=0;i<nTri*3;i++)
+            vertTris[fill[idx[i]]++]=i/3;
+
+        collapses.clear();
+        for(unsigned int i=0;i<nTri*3;i++){
+            unsigned int a=idx[i],b=idx[i/3*3+(i+1)%3];
+            for(int dir=0;dir<2;dir++){
+                unsigned int from= dir? b : a, to= dir? a : b;
+                if(locked[from])
+                    continue;
+                Quadric q=quadrics[from];
+                q.add(quadrics[to]);
+                Collapse c={(float)q.error(pts[to]),from,to};
+                if(c.cost<=maxCost)
+                    collapses.push_back(c);
+            }
+        }
+        if(collapses.empty())
+            break;
+        std::sort(collapses.begin(),collapses.end());
+
+        for(unsigned int v=0;v<nVerts;v++)
+            remap[v]=v;
+        std::fill(dirty,dirty+nVerts,0);
+        // a collapse takes two triangles with it
+        unsigned int toGo=nTri-targetTris,gone=0,done=0;
+        for(unsigned int i=0;i<collapses.size() && gone<toGo;i++){
+            const Collapse &c=collapses[i];
+            if(dirty[c.from] || dirty[c.to])
+                continue;
+            const unsigned int *ft=&vertTris[triStart[c.from]];
+            unsigned int nf=triStart[c.from+1]-triStart[c.from];
+            const unsigned int *tt=&vertTris[triStart[c.to]];
+            unsigned int nt=triStart[c.to+1]-triStart[c.to];
+            if(!collapseOk(pts,idx,ft,nf,tt,nt,c.from,c.to))
+                continue;
+            // furthest the planes from stands for are from its new place
+            float dist=0;
+            for(unsigned int k=head[c.from];k!=~0u;k=next[k]){
+                const glm::vec4 &pl=planes[k/3];
+                dist=std::max(dist,std::fabs(glm::dot(vec3(pl),pts[c.to])+pl.w));
+            }
+            if(dist>maxError)
+                continue;
+            remap[c.from]=c.to;
+            quadrics[c.to].add(quadrics[c.from]);
+            if(head[c.from]!=~0u){
+                if(head[c.to]==~0u)
+                    head[c.to]=head[c.from];
+                else
+                    next[tail[c.to]]=head[c.from];
+                tail[c.to]=tail[c.from];
+                head[c.from]=tail[c.from]=~0u;
+            }
+            worst=std::max(worst,dist);
+            // nothing around it can move again this pass, the triangles here are stale now
+            for(unsigned int k=0;k<nf;k++){
+                const unsigned int *t=&idx[3*ft[k]];
+                dirty[t[0]]=dirty[t[1]]=dirty[t[2]]=1;
+                gone+= t[0]==c.to || t[1]==c.to || t[2]==c.to;
+            }
+            done++;
+        }
+        if(!done)
+            break;
+
+        unsigned int out=0;
+        for(unsigned int t=0;t<nTri;t++){
+            unsigned int a=remap[idx[3*t]],b=remap[idx[3*t+1]],c=remap[idx[3*t+2]];
+            if(a==b || b==c || a==c)
+                continue;
+            idx[out++]=a;
+            idx[out++]=b;
+            idx[out++]=c;
+        }
+        idx.resize(out);
+        nTri=out/3;
+    }
+    return worst;
+}
@@ -0,0 +1,27 @@
+#ifndef MESHSIMPLIFY_H
+#define MESHSIMPLIFY_H
+
+// meshsimplify.h
+// Quadric error edge collapse (Garland & Heckbert, "Surface Simplification Using Quadric
+// Error Metrics"), for the far levels of detail.
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "mesharena.h"
+
+// Collapses edges of the indexed triangle mesh until it has at most targetTris triangles,
+// or until no collapse is left that keeps within maxError. Collapses are tried cheapest
+// first by their quadric (an area weighted mean squared distance), but the error that
+// counts is the real one: how far the moved vertex ends up from the plane of any original
+// triangle it stands for.
+// Every collapse moves a vertex onto one of its neighbours, so the vertices that are left
+// keep their exact position, color and normal. Vertices on open borders or seams (another
+// vertex at the same position, like the split vertices of makeFlatShade) never move, so
+// hard edges and holes keep their outline.
+// idx is rewritten and shrinks; vertices no triangle uses any more are left in place.
+// Returns the largest such distance over all collapses, in mesh units.
+// Temporary arrays come from scratch.
+float simplifyMesh(const glm::vec3 *pts, unsigned int nVerts, std::vector<unsigned int> &idx,
+                   unsigned int targetTris, float maxError, MeshArena &scratch);
+
+#endif // MESHSIMPLIFY_H
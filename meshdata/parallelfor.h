@@ -0,0 +1,35 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+// parallelfor.h
+// The one threading helper the mesh code uses.
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+// run f(begin,end) over [0,n) in chunks of grain, spread over the available cores.
+// Jobs with only one chunk run on the calling thread.
+template<class F>
+void parallelFor(unsigned int n, unsigned int grain, F f){
+    unsigned int nChunks=(n+grain-1)/grain;
+    unsigned int nThreads=std::min(nChunks,std::max(1u,std::thread::hardware_concurrency()));
+    if(nThreads<=1){
+        if(n) f(0u,n);
+        return;
+    }
+    std::atomic<unsigned int> next(0);
+    auto work=[&](){
+        for(unsigned int c=next++;c<nChunks;c=next++)
+            f(c*grain,std::min(n,(c+1)*grain));
+    };
+    std::vector<std::thread> threads;
+    for(unsigned int t=1;t<nThreads;t++)
+        threads.push_back(std::thread(work));
+    work();
+    for(unsigned int t=0;t<threads.size();t++)
+        threads[t].join();
+}
+
+#endif // PARALLELFOR_H